@@ -0,0 +1,331 @@
+/*
+ Throughput
+
+ Benchmark target for extras/throughput/ethperf, which measures goodput,
+ latency and jitter of TCP and UDP against this sketch.
+
+ The host selects a test over the control port (TCP 5000), the test
+ itself runs on port 5001:
+   tcp-sink <chunk> <streams>    accept streams connections, read and discard
+   tcp-source <chunk> <streams>  accept streams connections, send chunks
+                                 (at most SOCKETS - 2 streams, the info
+                                 reply tells how many are used)
+   tcp-echo <chunk>              send back what is received
+   udp-sink <chunk>              count received datagrams
+   udp-source <chunk>            "go <count>" sends count datagrams back
+   udp-echo <chunk>              send back every datagram
+   stats                         bytes and datagrams since the test started
+   info                          chip, buffer size, sockets and SPI clock
+ Every reply is one line, after which the control connection is closed.
+
+ Change SOCKETS and SPI_CLOCK to compare buffer sizes and SPI speeds, the
+ host program records them with every result.
+
+ created 18 Oct 2026
+ by Lode Van Dyck
+
+ This code is in the public domain.
+ */
+
+#include <EthernetAdv.h>
+
+#define CS_PIN 10
+#define SOCKETS 8        // 1, 2, 4 or 8: fewer sockets get larger buffers
+#define SPI_CLOCK 0      // Hz, 0 for the default of the chip
+
+#define CONTROL_PORT 5000
+#define DATA_PORT 5001
+
+// The control server always has a listening socket, and a second socket
+// while a control connection is open.  The streams get the rest.
+#define MAX_STREAMS (SOCKETS > 2 ? SOCKETS - 2 : 1)
+
+#if defined(__AVR__)
+#define MAX_CHUNK 256
+#else
+#define MAX_CHUNK 1472
+#endif
+
+W5x00Auto w5x00(SPI, CS_PIN, SOCKETS);   // Finds out if a W5100, W5200 or W5500 is connected
+EthernetClass Ethernet(w5x00);
+
+byte mac[] = {
+  0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED
+};
+IPAddress ip(192, 168, 1, 177);
+
+EthernetServer control(Ethernet, CONTROL_PORT);
+EthernetUDP udp(Ethernet);
+EthernetClient clients[SOCKETS] = {
+  EthernetClient(Ethernet)
+#if SOCKETS > 1
+  , EthernetClient(Ethernet)
+#endif
+#if SOCKETS > 2
+  , EthernetClient(Ethernet), EthernetClient(Ethernet)
+#endif
+#if SOCKETS > 4
+  , EthernetClient(Ethernet), EthernetClient(Ethernet)
+  , EthernetClient(Ethernet), EthernetClient(Ethernet)
+#endif
+};
+
+enum Test { NONE, TCP_SINK, TCP_SOURCE, TCP_ECHO, UDP_SINK, UDP_SOURCE, UDP_ECHO };
+const char *testNames[] = {
+  "none", "tcp-sink", "tcp-source", "tcp-echo", "udp-sink", "udp-source", "udp-echo"
+};
+
+Test test = NONE;
+uint16_t chunk = MAX_CHUNK;
+uint8_t streams = 1;
+uint8_t listeners[SOCKETS]; // listening sockets of the TCP tests
+uint8_t listening = 0;       // listeners[] in use
+uint8_t connected = 0;       // clients[] in use
+
+uint32_t started;
+uint32_t rxBytes, rxPackets, txBytes, txPackets;
+
+uint32_t sourceCount = 0;    // datagrams udp-source still has to send
+uint32_t sourceSeq;
+IPAddress sourceIP;
+uint16_t sourcePort;
+
+uint8_t buffer[MAX_CHUNK];
+
+void setup() {
+  Serial.begin(115200);
+  SPI.begin();
+#if SPI_CLOCK
+  w5x00.setSPIClock(SPI_CLOCK);
+#endif
+  Ethernet.begin(mac, ip);
+  if (!Ethernet.hardwareInitialized()) {
+    Serial.println("Ethernet hardware was not found.");
+    while (true) {
+      delay(1);
+    }
+  }
+  for (uint16_t i = 0; i < MAX_CHUNK; i++) {
+    buffer[i] = i;
+  }
+  control.begin();
+  Serial.print("Throughput target at ");
+  Serial.println(Ethernet.localIP());
+}
+
+void loop() {
+  EthernetClient c = control.available();
+  if (c) {
+    handleControl(c);
+  }
+
+  switch (test) {
+    case TCP_SINK:
+    case TCP_SOURCE:
+    case TCP_ECHO:
+      acceptClients();
+      runTcp();
+      break;
+    case UDP_SINK:
+    case UDP_SOURCE:
+    case UDP_ECHO:
+      runUdp();
+      break;
+    default:
+      break;
+  }
+}
+
+// Read one command line and answer it
+void handleControl(EthernetClient &c) {
+  char line[40];
+  uint8_t n = 0;
+  uint32_t start = millis();
+
+  while (c.connected() && millis() - start < 1000) {
+    int b = c.read();
+    if (b < 0) continue;
+    if (b == '\n' || n == sizeof(line) - 1) break;
+    if (b != '\r') line[n++] = b;
+  }
+  line[n] = 0;
+
+  char name[16];
+  unsigned int arg1 = 0, arg2 = 0;
+  int args = sscanf(line, "%15s %u %u", name, &arg1, &arg2);
+  if (args < 1) {
+    c.println("error");
+  } else if (strcmp(name, "info") == 0) {
+    printInfo(c);
+  } else if (strcmp(name, "stats") == 0) {
+    printStats(c);
+  } else if (startTest(name, arg1, arg2)) {
+    printInfo(c);
+  } else {
+    c.println("error");
+  }
+  c.stop();
+}
+
+void printInfo(Print &out) {
+  const char *chips[] = {"none", "W5100", "W5200", "W5500"};
+  out.print("chip=");
+  out.print(chips[w5x00.chip()]);
+  out.print(" ssize=");
+  out.print(Ethernet.SSIZE());
+  out.print(" sockets=");
+  out.print(Ethernet.maxSocketNum());
+  out.print(" spi=");
+  out.print(w5x00.spiClock());
+  out.print(" test=");
+  out.print(testNames[test]);
+  out.print(" chunk=");
+  out.print(chunk);
+  out.print(" streams=");
+  out.println(streams);
+}
+
+void printStats(Print &out) {
+  out.print("rx_bytes=");
+  out.print(rxBytes);
+  out.print(" rx_packets=");
+  out.print(rxPackets);
+  out.print(" tx_bytes=");
+  out.print(txBytes);
+  out.print(" tx_packets=");
+  out.print(txPackets);
+  out.print(" ms=");
+  out.println(millis() - started);
+}
+
+bool startTest(const char *name, unsigned int arg1, unsigned int arg2) {
+  Test t = NONE;
+  for (uint8_t i = 1; i < sizeof(testNames) / sizeof(testNames[0]); i++) {
+    if (strcmp(name, testNames[i]) == 0) t = (Test)i;
+  }
+  if (t == NONE) return false;
+
+  stopTest();
+  test = t;
+  chunk = (arg1 > 0 && arg1 <= MAX_CHUNK) ? arg1 : MAX_CHUNK;
+  streams = arg2 == 0 ? 1 : (arg2 <= MAX_STREAMS ? arg2 : MAX_STREAMS);
+  if (test == TCP_ECHO) streams = 1;
+  rxBytes = rxPackets = txBytes = txPackets = 0;
+  started = millis();
+
+  if (test == UDP_SINK || test == UDP_SOURCE || test == UDP_ECHO) {
+    udp.begin(DATA_PORT);
+  } else {
+    listen();
+  }
+  return true;
+}
+
+void stopTest() {
+  for (uint8_t i = 0; i < connected; i++) {
+    clients[i].stop();
+  }
+  connected = 0;
+  for (uint8_t i = 0; i < listening; i++) {
+    Ethernet.socketClose(listeners[i]);
+  }
+  listening = 0;
+  udp.stop();
+  sourceCount = 0;
+  test = NONE;
+}
+
+// The TCP tests use listening sockets of their own instead of an
+// EthernetServer, so they can be closed when the test changes.  There is
+// one for every stream that is not connected yet, so the host can open
+// all streams at once.
+void listen() {
+  while (connected + listening < streams) {
+    uint8_t s = Ethernet.socketBegin(SnMR::TCP, DATA_PORT);
+    if (s >= Ethernet.maxSocketNum()) return;
+    Ethernet.socketListen(s);
+    listeners[listening++] = s;
+  }
+}
+
+void acceptClients() {
+  // Forget clients that were closed by the host
+  for (uint8_t i = 0; i < connected; ) {
+    if (!clients[i].connected()) {
+      clients[i].stop();
+      clients[i] = clients[--connected];
+    } else {
+      i++;
+    }
+  }
+
+  for (uint8_t i = 0; i < listening; ) {
+    uint8_t status = Ethernet.socketStatus(listeners[i]);
+    if (status == SnSR::ESTABLISHED || status == SnSR::CLOSE_WAIT) {
+      clients[connected++] = EthernetClient(Ethernet, listeners[i]);
+      listeners[i] = listeners[--listening];
+    } else if (status == SnSR::CLOSED) {
+      listeners[i] = listeners[--listening];
+    } else {
+      i++;
+    }
+  }
+  listen();
+}
+
+void runTcp() {
+  for (uint8_t i = 0; i < connected; i++) {
+    EthernetClient &c = clients[i];
+    if (test == TCP_SOURCE) {
+      if (c.availableForWrite() >= chunk) {
+        txBytes += c.write(buffer, chunk);
+        txPackets++;
+      }
+      continue;
+    }
+    int n = c.read(buffer, chunk);
+    if (n <= 0) continue;
+    rxBytes += n;
+    rxPackets++;
+    if (test == TCP_ECHO) {
+      txBytes += c.write(buffer, n);
+      txPackets++;
+    }
+  }
+}
+
+void runUdp() {
+  int size = udp.parsePacket();
+  if (size > 0) {
+    int n = udp.read(buffer, chunk);
+    rxBytes += n;
+    rxPackets++;
+    if (test == UDP_ECHO) {
+      udp.beginPacket(udp.remoteIP(), udp.remotePort());
+      txBytes += udp.write(buffer, n);
+      udp.endPacket();
+      txPackets++;
+    } else if (test == UDP_SOURCE && n >= 3 && memcmp(buffer, "go ", 3) == 0) {
+      buffer[n < MAX_CHUNK ? n : MAX_CHUNK - 1] = 0;
+      sourceCount = strtoul((char *)buffer + 3, NULL, 10);
+      sourceSeq = 0;
+      sourceIP = udp.remoteIP();
+      sourcePort = udp.remotePort();
+      started = millis();
+    }
+  }
+
+  if (test == UDP_SOURCE && sourceCount > 0) {
+    // Every datagram starts with its sequence number, so the host can
+    // count lost and reordered datagrams
+    buffer[0] = sourceSeq >> 24;
+    buffer[1] = sourceSeq >> 16;
+    buffer[2] = sourceSeq >> 8;
+    buffer[3] = sourceSeq;
+    udp.beginPacket(sourceIP, sourcePort);
+    txBytes += udp.write(buffer, chunk);
+    if (udp.endPacket()) txPackets++;
+    sourceSeq++;
+    sourceCount--;
+  }
+}
@@ -0,0 +1,320 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Host test of the background transfers of the socket layer:
+// socketBufferDataAsync(), socketRecvAsync() and socketAsyncPoll().
+// The socket layer is built against a simulated chip whose background
+// transfers only finish when the test says so, to check that TX_WR and
+// RX_RD are only moved, the callback only called and the SPI transaction
+// only ended by the socketAsyncPoll() after the transfer has finished,
+// and that nothing else can start in the meantime.
+// It also checks that an EthernetUDP with asynchronous sending does not
+// copy to the chip while a packet is being sent, and learns the MAC address
+// of each packet for the destination of that packet.
+//
+// Build and run on Linux (host/ holds stand-ins for the Arduino core):
+//   S=../../src
+//   g++ -std=c++17 -Ihost -I$S -I$S/utility -o asynctest asynctest.cpp
+//       $S/socket.cpp $S/EthernetAdv.cpp $S/EthernetUdp.cpp $S/Dhcp.cpp $S/Dns.cpp
+//       $S/utility/W5x00.cpp $S/utility/W5x00Bus.cpp
+//       -ffunction-sections -fdata-sections -Wl,--gc-sections
+//
+// Exits with 0 if all checks pass, 1 otherwise.
+
+#include <stdio.h>
+#include <chrono>
+
+#include "EthernetAdv.h"
+
+unsigned long millis() { return micros() / 1000; }
+unsigned long micros()
+{
+	static auto start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+void delay(unsigned long) { }
+void delayMicroseconds(unsigned int) { }
+void yield() { }
+void pinMode(uint8_t, uint8_t) { }
+void digitalWrite(uint8_t, uint8_t) { }
+int digitalRead(uint8_t) { return 0; }
+long random(long max) { return rand() % max; }
+long random(long min, long max) { return min + rand() % (max - min); }
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+SPIClass SPI;
+
+// The W5100 memory map in a plain array.  Commands complete at once, and
+// background transfers only when finish() is called.  A SEND reports
+// SEND_OK after Sn_IR has been read a few times; a plain SEND resolves
+// 192.168.1.x to 02:00:00:00:00:x in Sn_DHAR.
+class SimChip : public W5x00Class {
+public:
+	SimChip() {
+		memset(mem, 0, sizeof(mem));
+		spi = &SPI;
+		_maxSockNum = 4;
+		CH_BASE_MSB = 0x04;
+		SSIZE = 2048;
+		SMASK = 0x07FF;
+		depth = 0;
+		starts = 0;
+		pending = false;
+		sendPolls = 0;
+		lastSend = 0;
+		txMoved = false;
+	}
+
+	uint8_t init() { return 1; }
+	uint8_t detect() { return 1; }
+	W5x00Linkstatus getLinkStatus() { return LINK_ON; }
+	W5x00Chip chip() { return CHIP_W5100; }
+	uint16_t SBASE(uint8_t s) { return 0x4000 + s * SSIZE; }
+	uint16_t RBASE(uint8_t s) { return 0x6000 + s * SSIZE; }
+	const bool hasOffsetAddressMapping() { return false; }
+
+	void beginTransaction() { depth++; }
+	void endTransaction() { if (depth > 0) depth--; }
+
+	uint16_t write(uint16_t addr, const uint8_t *buf, uint16_t len) {
+		uint16_t reg = addr - CH_BASE();
+		bool sock = addr >= CH_BASE() && addr < CH_BASE() + 4 * CH_SIZE;
+		if (sock && reg % CH_SIZE == 2) {
+			mem[addr] &= ~buf[0]; // writing 1 clears an Sn_IR bit
+			return len;
+		}
+		memcpy(mem + addr, buf, len);
+		if (sock && reg % CH_SIZE == 1) {
+			command(reg / CH_SIZE, buf[0]);
+		}
+		return len;
+	}
+	uint16_t read(uint16_t addr, uint8_t *buf, uint16_t len) {
+		uint16_t reg = addr - CH_BASE();
+		if (addr >= CH_BASE() && addr < CH_BASE() + 4 * CH_SIZE && reg % CH_SIZE == 2 && sendPolls > 0) {
+			uint8_t s = reg / CH_SIZE;
+			if (readSnTX_WR(s) != sendWr) txMoved = true;
+			if (--sendPolls == 0) mem[addr] |= SnIR::SEND_OK;
+		}
+		memcpy(buf, mem + addr, len);
+		return len;
+	}
+
+	uint16_t writeAsync(uint16_t addr, const uint8_t *buf, uint16_t len) {
+		start(addr, (uint8_t *)buf, len, true);
+		return len;
+	}
+	uint16_t readAsync(uint16_t addr, uint8_t *buf, uint16_t len) {
+		start(addr, buf, len, false);
+		return len;
+	}
+	bool asyncDone() { return !pending; }
+
+	// Let the background transfer in progress finish
+	void finish() {
+		if (!pending) return;
+		if (pendingWrite) {
+			memcpy(mem + pendingAddr, pendingBuf, pendingLen);
+		} else {
+			memcpy(pendingBuf, mem + pendingAddr, pendingLen);
+		}
+		pending = false;
+	}
+
+	uint8_t mem[0x10000];
+	int depth;     // open SPI transactions
+	int starts;    // background transfers started
+	uint8_t lastSend;    // command of the last SEND
+	uint8_t lastDHAR[6]; // Sn_DHAR the last SEND went to
+	bool txMoved;  // TX_WR moved while a SEND was in progress
+
+private:
+	bool pending;
+	bool pendingWrite;
+	uint16_t pendingAddr;
+	uint8_t *pendingBuf;
+	uint16_t pendingLen;
+	int sendPolls;
+	uint16_t sendWr;
+
+	void start(uint16_t addr, uint8_t *buf, uint16_t len, bool isWrite) {
+		pending = true;
+		pendingWrite = isWrite;
+		pendingAddr = addr;
+		pendingBuf = buf;
+		pendingLen = len;
+		starts++;
+	}
+
+	void command(uint8_t s, uint8_t cmd) {
+		uint16_t base = CH_BASE() + s * CH_SIZE;
+		if (cmd == Sock_OPEN) mem[base + 3] = SnSR::INIT;
+		if (cmd == Sock_CLOSE) mem[base + 3] = SnSR::CLOSED;
+		if (cmd == Sock_SEND || cmd == Sock_SEND_MAC) {
+			if (cmd == Sock_SEND) {
+				uint8_t mac[6] = { 0x02, 0, 0, 0, 0, mem[base + 0x0C + 3] };
+				memcpy(mem + base + 0x06, mac, 6);
+			}
+			memcpy(lastDHAR, mem + base + 0x06, 6);
+			lastSend = cmd;
+			sendWr = readSnTX_WR(s);
+			sendPolls = 3;
+		}
+		mem[base + 1] = 0; // the command is done
+	}
+};
+
+static SimChip chip;
+static EthernetClass eth(chip);
+static int failures = 0;
+static int callbacks = 0;
+static uint16_t callbackLen = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+static void onDone(uint8_t s, uint16_t len)
+{
+	callbacks++;
+	callbackLen = len;
+}
+
+// Open a socket and make it look connected
+static uint8_t connectedSocket()
+{
+	uint8_t s = eth.socketBegin(SnMR::TCP, 80);
+	chip.writeSnSR(s, SnSR::ESTABLISHED);
+	chip.writeSnTX_FSR(s, chip.SSIZE);
+	return s;
+}
+
+static void testSend()
+{
+	uint8_t s = connectedSocket();
+	uint8_t data[200], busy[8];
+	for (int i = 0; i < 200; i++) data[i] = i;
+	uint16_t wr = chip.readSnTX_WR(s);
+	callbacks = 0;
+
+	CHECK(eth.socketBufferDataAsync(s, 0, data, sizeof(data)) == sizeof(data));
+	CHECK(chip.depth == 1);                          // the bus stays taken
+	CHECK(!eth.socketAsyncPoll());
+	CHECK(chip.readSnTX_WR(s) == wr);                 // not moved before it is done
+	CHECK(callbacks == 0);
+	// Nothing else starts while the transfer is in progress
+	CHECK(eth.socketBufferDataAsync(s, 0, busy, sizeof(busy)) == 0);
+	CHECK(eth.socketRecvAsync(s, busy, sizeof(busy)) == -2);
+
+	chip.finish();
+	CHECK(eth.socketAsyncPoll());
+	CHECK(chip.depth == 0);
+	CHECK(chip.readSnTX_WR(s) == (uint16_t)(wr + sizeof(data)));
+	CHECK(callbacks == 1 && callbackLen == sizeof(data));
+	CHECK(memcmp(chip.mem + chip.SBASE(s) + (wr & chip.SMASK), data, sizeof(data)) == 0);
+	CHECK(eth.socketAsyncPoll());                     // nothing left to finish
+	CHECK(callbacks == 1);
+
+	eth.socketClose(s);
+}
+
+static void testRecv()
+{
+	uint8_t s = connectedSocket();
+	uint8_t data[100], buf[100];
+	for (int i = 0; i < 100; i++) data[i] = 100 - i;
+	memcpy(chip.mem + chip.RBASE(s), data, sizeof(data));
+	chip.writeSnRX_RSR(s, sizeof(data));
+	callbacks = 0;
+
+	// Read part of the data
+	memset(buf, 0, sizeof(buf));
+	CHECK(eth.socketRecvAsync(s, buf, 60) == 60);
+	CHECK(chip.depth == 1);
+	CHECK(!eth.socketAsyncPoll());
+	CHECK(eth.socketRecvAsync(s, buf, 60) == -2);     // busy, not "no data"
+	CHECK(callbacks == 0);
+	chip.finish();
+	CHECK(eth.socketAsyncPoll());
+	CHECK(chip.depth == 0);
+	CHECK(callbacks == 1 && callbackLen == 60);
+	CHECK(memcmp(buf, data, 60) == 0);
+
+	// The rest starts where the first read stopped
+	CHECK(eth.socketRecvAsync(s, buf, sizeof(buf)) == 40);
+	chip.finish();
+	CHECK(eth.socketAsyncPoll());
+	CHECK(memcmp(buf, data + 60, 40) == 0);
+	CHECK(chip.readSnRX_RD(s) == sizeof(data));       // all given back to the chip
+	chip.writeSnRX_RSR(s, 0);
+
+	// Nothing to read: -1 while connected, 0 once closed
+	CHECK(eth.socketRecvAsync(s, buf, sizeof(buf)) == -1);
+	CHECK(chip.depth == 0);
+	chip.writeSnSR(s, SnSR::CLOSE_WAIT);
+	CHECK(eth.socketRecvAsync(s, buf, sizeof(buf)) == 0);
+	CHECK(chip.depth == 0);
+
+	eth.socketClose(s);
+}
+
+// Two packets in a row to different peers, the second one built while
+// the first one is still being sent
+static void testUdpLearn()
+{
+	EthernetUDP udp(eth);
+	uint8_t data[32], mac[6];
+	const IPAddress a(192, 168, 1, 10), b(192, 168, 1, 20);
+	memset(data, 0x55, sizeof(data));
+	eth.setSubnetMask(IPAddress(255, 255, 255, 0));
+	CHECK(udp.begin(5000));
+	chip.writeSnTX_FSR(0, chip.SSIZE);
+	udp.setAsyncSend(true);
+	udp.learnRemoteMAC();
+
+	CHECK(udp.beginPacket(a, 9000));
+	CHECK(udp.write(data, sizeof(data)) == sizeof(data));
+	CHECK(udp.endPacket() == 1);
+	CHECK(chip.lastSend == Sock_SEND && chip.lastDHAR[5] == 10);
+	CHECK(udp.pollSend() == -1);
+
+	CHECK(udp.beginPacket(b, 9000));
+	CHECK(udp.write(data, sizeof(data)) == sizeof(data));
+	CHECK(!chip.txMoved);
+	// The MAC address of the first packet is learned for a, not for b
+	CHECK(udp.remoteMAC(a, mac) && mac[5] == 10);
+	CHECK(!udp.remoteMAC(b, mac));
+	CHECK(udp.endPacket() == 1);
+	CHECK(chip.lastSend == Sock_SEND && chip.lastDHAR[5] == 20);
+
+	// The next packet to a goes to the learned address
+	CHECK(udp.beginPacket(a, 9000));
+	CHECK(udp.write(data, sizeof(data)) == sizeof(data));
+	CHECK(udp.endPacket() == 1);
+	CHECK(chip.lastSend == Sock_SEND_MAC && chip.lastDHAR[5] == 10);
+	while (udp.pollSend() < 0) { }
+	CHECK(!chip.txMoved);
+	CHECK(udp.sendTimeouts() == 0);
+
+	udp.stop();
+}
+
+int main()
+{
+	eth.setAsyncCallback(onDone);
+	testSend();
+	testRecv();
+	testUdpLearn();
+	CHECK(chip.starts == 3);
+	if (failures) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
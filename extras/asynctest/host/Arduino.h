@@ -0,0 +1,78 @@
+// Minimal stand-in for the Arduino core, enough to build the socket layer
+// of the library on a host.  Only used by the host tests in extras/.
+
+#ifndef ARDUINO_H_HOST
+#define ARDUINO_H_HOST
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+long random(long max);
+long random(long min, long max);
+
+class Print {
+public:
+	virtual ~Print() { }
+	virtual size_t write(uint8_t) = 0;
+	virtual size_t write(const uint8_t *buf, size_t size) {
+		size_t n = 0;
+		while (size--) n += write(*buf++);
+		return n;
+	}
+	size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+	size_t print(const char *str) { return write(str); }
+	size_t println(const char *str = "") { return write(str) + write("\r\n"); }
+	virtual void flush() { }
+	void setWriteError(int err = 1) { _writeError = err; }
+	int getWriteError() { return _writeError; }
+private:
+	int _writeError = 0;
+};
+
+class Stream : public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+};
+
+class IPAddress {
+public:
+	IPAddress() { memset(_a, 0, 4); }
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _a[0] = a; _a[1] = b; _a[2] = c; _a[3] = d; }
+	IPAddress(uint32_t v) { memcpy(_a, &v, 4); }
+	IPAddress(const uint8_t *p) { memcpy(_a, p, 4); }
+	operator uint32_t() const { uint32_t v; memcpy(&v, _a, 4); return v; }
+	bool operator==(const IPAddress &o) const { return memcmp(_a, o._a, 4) == 0; }
+	bool operator!=(const IPAddress &o) const { return !(*this == o); }
+	bool operator==(const uint8_t *p) const { return memcmp(_a, p, 4) == 0; }
+	uint8_t operator[](int i) const { return _a[i]; }
+	uint8_t& operator[](int i) { return _a[i]; }
+	IPAddress& operator=(const uint8_t *p) { memcpy(_a, p, 4); return *this; }
+	IPAddress& operator=(uint32_t v) { memcpy(_a, &v, 4); return *this; }
+	uint8_t* raw_address() { return _a; }
+private:
+	uint8_t _a[4];
+};
+
+extern const IPAddress INADDR_NONE;
+
+#endif
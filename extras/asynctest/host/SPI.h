@@ -0,0 +1,28 @@
+// Minimal stand-in for the Arduino SPI library, see Arduino.h
+
+#ifndef SPI_H_HOST
+#define SPI_H_HOST
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+class SPISettings {
+public:
+	SPISettings() { }
+	SPISettings(uint32_t, uint8_t, uint8_t) { }
+};
+
+class SPIClass {
+public:
+	void begin() { }
+	void beginTransaction(SPISettings) { }
+	void endTransaction() { }
+	uint8_t transfer(uint8_t data) { return data; }
+	void transfer(void *, size_t) { }
+};
+
+extern SPIClass SPI;
+
+#endif
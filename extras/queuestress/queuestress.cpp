@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Stress test of the lock-free queues used by EthernetTask
+// (src/utility/EthernetQueue.h) with host threads.  Several producers push
+// numbered items into one EthernetMPSCQueue while another thread feeds an
+// EthernetSPSCQueue, and a single consumer drains both.  Every item must
+// arrive exactly once and in the order its producer pushed it.  The queues
+// are kept small so they wrap and run full all the time.
+//
+// Build and run on Linux, preferably also with ThreadSanitizer:
+//   g++ -O2 -std=c++17 -pthread -I../../src/utility -o queuestress queuestress.cpp
+//   g++ -O1 -g -std=c++17 -pthread -fsanitize=thread -I../../src/utility -o queuestress queuestress.cpp
+//
+// Usage: queuestress [producers] [items per producer]
+// Exits with 0 if all items arrived in order, 1 otherwise.
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "EthernetQueue.h"
+
+struct Item {
+	uint32_t producer;
+	uint32_t seq;
+};
+
+static EthernetMPSCQueue<Item, 16> mpsc;
+static EthernetSPSCQueue<uint32_t, 8> spsc;
+
+int main(int argc, char **argv)
+{
+	uint32_t producers = argc > 1 ? atoi(argv[1]) : 4;
+	uint32_t items = argc > 2 ? atoi(argv[2]) : 200000;
+	if (producers == 0 || items == 0) {
+		fprintf(stderr, "usage: queuestress [producers] [items per producer]\n");
+		return 2;
+	}
+
+	std::vector<std::thread> threads;
+	for (uint32_t p = 0; p < producers; p++) {
+		threads.emplace_back([p, items] {
+			for (uint32_t n = 0; n < items; ) {
+				if (mpsc.push(Item{p, n})) {
+					n++;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+	threads.emplace_back([items] {
+		for (uint32_t n = 0; n < items; ) {
+			if (spsc.push(n)) {
+				n++;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	// Drain both queues until everything has arrived, so no producer is
+	// left waiting for room when the threads are joined
+	std::vector<uint32_t> next(producers, 0);
+	uint64_t received = 0, total = (uint64_t)producers * items;
+	uint32_t spscNext = 0;
+	uint64_t errors = 0;
+	while (received < total || spscNext < items) {
+		bool any = false;
+		Item item;
+		while (mpsc.pop(item)) {
+			any = true;
+			if (item.producer >= producers || item.seq != next[item.producer]) {
+				errors++;
+			} else {
+				next[item.producer]++;
+			}
+			received++;
+		}
+		uint32_t v;
+		while (spsc.pop(v)) {
+			any = true;
+			if (v != spscNext) errors++;
+			spscNext++;
+		}
+		if (!any) std::this_thread::yield();
+	}
+	for (auto &t : threads) t.join();
+
+	Item item;
+	uint32_t v;
+	if (mpsc.pop(item) || spsc.pop(v)) errors++;
+
+	printf("MPSC: %u producers, %llu items; SPSC: %u items; %llu errors\n",
+		producers, (unsigned long long)received, spscNext, (unsigned long long)errors);
+	return errors ? 1 : 0;
+}
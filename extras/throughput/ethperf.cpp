@@ -0,0 +1,386 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Host side of the Throughput example: measures goodput, latency and jitter
+// of TCP and UDP against a board running examples/Throughput.
+//
+// Build on Linux:  g++ -O2 -std=c++17 -pthread -o ethperf ethperf.cpp
+//
+// Usage: ethperf <ip> <test> [options]
+//   tests   tcp-sink tcp-source tcp-echo udp-sink udp-source udp-echo
+//   -t s    duration in seconds (default 10)
+//   -l n    chunk / datagram size in bytes (default 1024)
+//   -P n    parallel TCP streams (default 1)
+//   -n n    datagrams for udp-source (default 10000)
+//   -b n    send rate limit in kbit/s for udp-sink and udp-echo (default none)
+//   -c file append the result as a CSV line to file
+//
+// The board's chip, socket buffer size, number of sockets and SPI clock
+// are part of every result, so runs with different settings of the sketch
+// can be put side by side from the CSV file.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CONTROL_PORT 5000
+#define DATA_PORT 5001
+
+typedef std::chrono::steady_clock Clock;
+typedef std::map<std::string, std::string> Fields;
+
+struct Options {
+	std::string ip;
+	std::string test;
+	double seconds = 10;
+	int chunk = 1024;
+	int streams = 1;
+	long count = 10000;
+	long rate = 0;       // kbit/s, 0 = unlimited
+	std::string csv;
+};
+
+struct Result {
+	double seconds = 0;
+	uint64_t bytes = 0;   // payload that arrived
+	uint64_t sent = 0;    // datagrams sent, for the loss
+	uint64_t received = 0;
+	std::vector<double> rtt; // us
+};
+
+static double since(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void fail(const char *what)
+{
+	perror(what);
+	exit(1);
+}
+
+static sockaddr_in address(const std::string &ip, int port)
+{
+	sockaddr_in a;
+	memset(&a, 0, sizeof(a));
+	a.sin_family = AF_INET;
+	a.sin_port = htons(port);
+	if (inet_pton(AF_INET, ip.c_str(), &a.sin_addr) != 1) {
+		fprintf(stderr, "invalid address %s\n", ip.c_str());
+		exit(1);
+	}
+	return a;
+}
+
+static int tcpConnect(const std::string &ip, int port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) fail("socket");
+	sockaddr_in a = address(ip, port);
+	if (connect(fd, (sockaddr *)&a, sizeof(a)) < 0) fail("connect");
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return fd;
+}
+
+static int udpSocket(const std::string &ip, int port)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) fail("socket");
+	sockaddr_in a = address(ip, port);
+	if (connect(fd, (sockaddr *)&a, sizeof(a)) < 0) fail("connect");
+	return fd;
+}
+
+// Wait up to ms for fd to become readable
+static bool readable(int fd, int ms)
+{
+	pollfd p = {fd, POLLIN, 0};
+	return poll(&p, 1, ms) > 0;
+}
+
+static bool writable(int fd, int ms)
+{
+	pollfd p = {fd, POLLOUT, 0};
+	return poll(&p, 1, ms) > 0;
+}
+
+// Send one command to the control port, returns the reply as key=value pairs
+static Fields command(const Options &o, const std::string &cmd)
+{
+	int fd = tcpConnect(o.ip, CONTROL_PORT);
+	std::string line = cmd + "\n";
+	if (write(fd, line.data(), line.size()) < 0) fail("write");
+	std::string reply;
+	char buf[256];
+	while (readable(fd, 2000)) {
+		ssize_t n = read(fd, buf, sizeof(buf));
+		if (n <= 0) break;
+		reply.append(buf, n);
+	}
+	close(fd);
+
+	Fields f;
+	std::istringstream in(reply);
+	std::string word;
+	while (in >> word) {
+		size_t eq = word.find('=');
+		if (eq != std::string::npos) f[word.substr(0, eq)] = word.substr(eq + 1);
+	}
+	if (f.empty()) {
+		fprintf(stderr, "%s: unexpected reply '%s'\n", cmd.c_str(), reply.c_str());
+		exit(1);
+	}
+	return f;
+}
+
+// Sleep so that bytes sent since start stay below the rate limit
+static void pace(const Options &o, Clock::time_point start, uint64_t bytes)
+{
+	if (!o.rate) return;
+	double due = bytes * 8.0 / (o.rate * 1000.0);
+	double ahead = due - since(start);
+	if (ahead > 0) std::this_thread::sleep_for(std::chrono::duration<double>(ahead));
+}
+
+static void tcpStreams(const Options &o, bool upload, Result &r)
+{
+	std::atomic<uint64_t> total(0);
+	std::vector<std::thread> threads;
+	Clock::time_point start = Clock::now();
+
+	for (int i = 0; i < o.streams; i++) {
+		threads.emplace_back([&]() {
+			int fd = tcpConnect(o.ip, DATA_PORT);
+			std::vector<char> buf(o.chunk, 'x');
+			while (since(start) < o.seconds) {
+				ssize_t n;
+				if (upload) {
+					if (!writable(fd, 100)) continue;
+					n = write(fd, buf.data(), buf.size());
+				} else {
+					if (!readable(fd, 100)) continue;
+					n = read(fd, buf.data(), buf.size());
+				}
+				if (n <= 0) break;
+				total += n;
+			}
+			close(fd);
+		});
+	}
+	for (auto &t : threads) t.join();
+	r.seconds = since(start);
+	r.bytes = total;
+}
+
+static void tcpEcho(const Options &o, Result &r)
+{
+	int fd = tcpConnect(o.ip, DATA_PORT);
+	std::vector<char> buf(o.chunk, 'x');
+	Clock::time_point start = Clock::now();
+
+	while (since(start) < o.seconds) {
+		Clock::time_point t = Clock::now();
+		if (write(fd, buf.data(), buf.size()) < 0) break;
+		size_t got = 0;
+		while (got < buf.size() && readable(fd, 1000)) {
+			ssize_t n = read(fd, buf.data() + got, buf.size() - got);
+			if (n <= 0) break;
+			got += n;
+		}
+		if (got < buf.size()) break;
+		r.rtt.push_back(since(t) * 1e6);
+		r.bytes += got;
+	}
+	close(fd);
+	r.seconds = since(start);
+}
+
+static void udpSink(const Options &o, Result &r)
+{
+	int fd = udpSocket(o.ip, DATA_PORT);
+	std::vector<char> buf(o.chunk, 'x');
+	Clock::time_point start = Clock::now();
+
+	while (since(start) < o.seconds) {
+		if (send(fd, buf.data(), buf.size(), 0) < 0) continue; // e.g. ENOBUFS
+		r.sent++;
+		pace(o, start, r.sent * buf.size());
+	}
+	r.seconds = since(start);
+	close(fd);
+	usleep(200000); // let the board read what is still in its buffer
+}
+
+static void udpSource(const Options &o, Result &r)
+{
+	int fd = udpSocket(o.ip, DATA_PORT);
+	int size = 4 << 20;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	std::string go = "go " + std::to_string(o.count);
+	if (send(fd, go.data(), go.size(), 0) < 0) fail("send");
+
+	std::vector<char> buf(65536);
+	std::vector<bool> seen(o.count, false);
+	Clock::time_point first = Clock::now(), last = first;
+	while (readable(fd, r.received ? 500 : 2000)) {
+		ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+		if (n < 4) continue;
+		uint32_t seq = ((uint8_t)buf[0] << 24) | ((uint8_t)buf[1] << 16) |
+			((uint8_t)buf[2] << 8) | (uint8_t)buf[3];
+		if (seq >= (uint32_t)o.count || seen[seq]) continue;
+		seen[seq] = true;
+		last = Clock::now();
+		if (!r.received) first = last;
+		r.received++;
+		r.bytes += n;
+	}
+	close(fd);
+	r.sent = o.count;
+	r.seconds = std::chrono::duration<double>(last - first).count();
+}
+
+static void udpEcho(const Options &o, Result &r)
+{
+	int fd = udpSocket(o.ip, DATA_PORT);
+	std::vector<char> buf(std::max(o.chunk, 8), 'x');
+	std::vector<char> in(65536);
+	Clock::time_point start = Clock::now();
+	uint32_t seq = 0;
+
+	while (since(start) < o.seconds) {
+		memcpy(buf.data(), &seq, 4);
+		Clock::time_point t = Clock::now();
+		if (send(fd, buf.data(), o.chunk, 0) < 0) continue;
+		r.sent++;
+		// Wait for this datagram, older replies that arrive late are skipped
+		while (readable(fd, 200)) {
+			ssize_t n = recv(fd, in.data(), in.size(), 0);
+			if (n >= 4 && memcmp(in.data(), &seq, 4) == 0) {
+				r.rtt.push_back(since(t) * 1e6);
+				r.received++;
+				r.bytes += n;
+				break;
+			}
+		}
+		seq++;
+		pace(o, start, r.sent * o.chunk);
+	}
+	close(fd);
+	r.seconds = since(start);
+}
+
+int main(int argc, char **argv)
+{
+	Options o;
+	int opt;
+	while ((opt = getopt(argc, argv, "t:l:P:n:b:c:")) != -1) {
+		switch (opt) {
+		case 't': o.seconds = atof(optarg); break;
+		case 'l': o.chunk = atoi(optarg); break;
+		case 'P': o.streams = atoi(optarg); break;
+		case 'n': o.count = atol(optarg); break;
+		case 'b': o.rate = atol(optarg); break;
+		case 'c': o.csv = optarg; break;
+		default:  return 1;
+		}
+	}
+	if (argc - optind != 2) {
+		fprintf(stderr, "usage: %s <ip> <test> [-t seconds] [-l chunk] [-P streams]"
+			" [-n count] [-b kbit/s] [-c file.csv]\n", argv[0]);
+		return 1;
+	}
+	o.ip = argv[optind];
+	o.test = argv[optind + 1];
+	if (o.chunk < 4) o.chunk = 4;
+
+	Fields info = command(o, o.test + " " + std::to_string(o.chunk) + " " +
+		std::to_string(o.streams));
+	o.chunk = atoi(info["chunk"].c_str()); // the board may limit it
+	o.streams = atoi(info["streams"].c_str());
+	printf("%s ssize=%s sockets=%s spi=%s test=%s chunk=%d streams=%d\n",
+		info["chip"].c_str(), info["ssize"].c_str(), info["sockets"].c_str(),
+		info["spi"].c_str(), o.test.c_str(), o.chunk, o.streams);
+
+	Result r;
+	if (o.test == "tcp-sink") tcpStreams(o, true, r);
+	else if (o.test == "tcp-source") tcpStreams(o, false, r);
+	else if (o.test == "tcp-echo") tcpEcho(o, r);
+	else if (o.test == "udp-sink") udpSink(o, r);
+	else if (o.test == "udp-source") udpSource(o, r);
+	else if (o.test == "udp-echo") udpEcho(o, r);
+
+	// What the board received is what counts for the sinks
+	Fields stats = command(o, "stats");
+	if (o.test == "tcp-sink" || o.test == "udp-sink") {
+		r.bytes = strtoull(stats["rx_bytes"].c_str(), NULL, 10);
+		r.received = strtoull(stats["rx_packets"].c_str(), NULL, 10);
+	}
+
+	double goodput = r.seconds > 0 ? r.bytes * 8 / r.seconds / 1e6 : 0;
+	double loss = r.sent ? 100.0 * (r.sent - std::min(r.sent, r.received)) / r.sent : 0;
+	double avg = 0, min = 0, max = 0, p99 = 0, jitter = 0;
+	if (!r.rtt.empty()) {
+		for (size_t i = 0; i < r.rtt.size(); i++) {
+			avg += r.rtt[i];
+			// Interarrival jitter estimator of RFC 3550, section 6.4.1,
+			// with D the difference between consecutive round trips
+			if (i) jitter += (fabs(r.rtt[i] - r.rtt[i - 1]) - jitter) / 16;
+		}
+		avg /= r.rtt.size();
+		std::vector<double> sorted = r.rtt;
+		std::sort(sorted.begin(), sorted.end());
+		min = sorted.front();
+		max = sorted.back();
+		p99 = sorted[(sorted.size() - 1) * 99 / 100];
+	}
+
+	printf("goodput %.3f Mbit/s, %llu bytes in %.2f s\n", goodput,
+		(unsigned long long)r.bytes, r.seconds);
+	if (r.sent) {
+		printf("datagrams %llu sent, %llu received, %.2f %% lost\n",
+			(unsigned long long)r.sent, (unsigned long long)r.received, loss);
+	}
+	if (!r.rtt.empty()) {
+		printf("round trip min %.0f avg %.0f p99 %.0f max %.0f us, jitter %.0f us\n",
+			min, avg, p99, max, jitter);
+	}
+
+	if (!o.csv.empty()) {
+		FILE *f = fopen(o.csv.c_str(), "a");
+		if (!f) fail(o.csv.c_str());
+		fseek(f, 0, SEEK_END);
+		if (ftell(f) == 0) {
+			fprintf(f, "chip,ssize,sockets,spi,test,chunk,streams,seconds,"
+				"goodput_mbit,loss_pct,rtt_avg_us,rtt_p99_us,jitter_us\n");
+		}
+		fprintf(f, "%s,%s,%s,%s,%s,%d,%d,%.2f,%.3f,%.2f,%.0f,%.0f,%.0f\n",
+			info["chip"].c_str(), info["ssize"].c_str(), info["sockets"].c_str(),
+			info["spi"].c_str(), o.test.c_str(), o.chunk, o.streams, r.seconds,
+			goodput, loss, avg, p99, jitter);
+		fclose(f);
+	}
+	return 0;
+}
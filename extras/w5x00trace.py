@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+#
+# Copyright 2026 Lode Van Dyck
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of either the GNU General Public License version 2
+# or the GNU Lesser General Public License version 2.1, both as
+# published by the Free Software Foundation.
+
+"""Analyse a dump written by W5x00Trace::dump().
+
+Prints the SPI accesses as per-socket timelines, a summary per socket and
+register reads that returned the same value as the previous read of that
+register without anything written in between (e.g. the double reads of
+Sn_RX_RSR and Sn_TX_FSR).
+
+The dump may be surrounded by other output, e.g. a capture of the serial
+port: everything before the "W5TR" header is skipped.
+
+    w5x00trace.py trace.bin                 summary and redundant reads
+    w5x00trace.py --timeline trace.bin      also every access
+    w5x00trace.py --timeline --socket 1 trace.bin
+"""
+
+import argparse
+import collections
+import struct
+import sys
+
+CHIPS = {1: "W5100", 2: "W5200", 3: "W5500"}
+
+# Base of the socket registers, transmit and receive buffers as addressed
+# by the library (W5x00Class::CH_BASE(), SBASE() and RBASE()).
+MAPS = {
+    "W5100": (0x0400, 0x4000, 0x6000),
+    "W5200": (0x4000, 0x8000, 0xC000),
+    "W5500": (0x1000, 0x8000, 0xC000),
+}
+
+COMMON_REGS = {
+    0x00: "MR", 0x01: "GAR", 0x05: "SUBR", 0x09: "SHAR", 0x0F: "SIPR",
+    0x15: "IR", 0x16: "IMR", 0x17: "RTR", 0x19: "RCR",
+}
+VERSION_REGS = {"W5200": {0x1F: "VERSIONR", 0x35: "PSTATUS"},
+                "W5500": {0x2E: "PHYCFGR", 0x39: "VERSIONR"}}
+
+SOCKET_REGS = {
+    0x00: "MR", 0x01: "CR", 0x02: "IR", 0x03: "SR", 0x04: "PORT",
+    0x06: "DHAR", 0x0C: "DIPR", 0x10: "DPORT", 0x12: "MSSR", 0x14: "PROTO",
+    0x15: "TOS", 0x16: "TTL", 0x1E: "RX_SIZE", 0x1F: "TX_SIZE",
+    0x20: "TX_FSR", 0x22: "TX_RD", 0x24: "TX_WR", 0x26: "RX_RSR",
+    0x28: "RX_RD", 0x2A: "RX_WR", 0x2F: "KPALVTR",
+}
+
+COMMANDS = {
+    0x01: "OPEN", 0x02: "LISTEN", 0x04: "CONNECT", 0x08: "DISCON",
+    0x10: "CLOSE", 0x20: "SEND", 0x21: "SEND_MAC", 0x22: "SEND_KEEP",
+    0x40: "RECV",
+}
+
+TRACE_WRITE = 0x01
+TRACE_ASYNC = 0x02
+
+Header = collections.namedtuple(
+    "Header", "version chip sockets ssize count dropped")
+Record = collections.namedtuple(
+    "Record", "time duration addr len value flags")
+
+
+def parse(data):
+    start = data.find(b"W5TR")
+    if start < 0:
+        raise ValueError("no W5TR header found")
+    (version, chip, sockets, _, ssize, count,
+     dropped) = struct.unpack_from("<BBBBHHI", data, start + 4)
+    if version != 1:
+        raise ValueError("unsupported dump version %d" % version)
+    header = Header(version, chip, sockets, ssize, count, dropped)
+    records = []
+    pos = start + 16
+    for _ in range(count):
+        if pos + 13 > len(data):
+            print("warning: dump is truncated", file=sys.stderr)
+            break
+        records.append(Record(*struct.unpack_from("<IHHHHB", data, pos)))
+        pos += 13
+    return header, records
+
+
+class Decoder:
+    """Turns an address into (socket, area, name).  socket is None for the
+    common registers, area is "reg", "tx" or "rx"."""
+
+    def __init__(self, chip, sockets, ssize):
+        self.chip = chip
+        self.sockets = sockets
+        self.ssize = ssize or 2048
+        self.ch_base, self.tx_base, self.rx_base = MAPS.get(
+            chip, MAPS["W5500"])
+
+    def decode(self, addr):
+        if self.rx_base <= addr < self.rx_base + 8 * self.ssize:
+            return (addr - self.rx_base) // self.ssize, "rx", "RX buffer"
+        if self.tx_base <= addr < self.tx_base + 8 * self.ssize:
+            return (addr - self.tx_base) // self.ssize, "tx", "TX buffer"
+        if self.ch_base <= addr < self.ch_base + 8 * 0x100:
+            s = (addr - self.ch_base) >> 8
+            reg = addr & 0xFF
+            return s, "reg", "Sn_" + SOCKET_REGS.get(reg, "0x%02X" % reg)
+        name = VERSION_REGS.get(self.chip, {}).get(addr)
+        name = name or COMMON_REGS.get(addr, "0x%04X" % addr)
+        return None, "reg", name
+
+
+def describe(rec, name, area):
+    write = rec.flags & TRACE_WRITE
+    if area != "reg":
+        text = "%s %s %d bytes" % ("write" if write else "read", name,
+                                   rec.len)
+        if rec.flags & TRACE_ASYNC:
+            text += " (background)"
+        return text
+    if write and name == "Sn_CR":
+        return "command %s" % COMMANDS.get(rec.value, "0x%02X" % rec.value)
+    value = ""
+    if rec.len <= 2:
+        value = " = 0x%0*X" % (rec.len * 2, rec.value)
+    return "%s %s%s" % ("write" if write else "read ", name, value)
+
+
+def analyse(header, records, args):
+    chip = CHIPS.get(header.chip, "unknown")
+    dec = Decoder(chip, header.sockets, header.ssize)
+    print("%s, %d sockets of %d bytes, %d records, %d dropped" % (
+        chip, header.sockets, header.ssize, len(records), header.dropped))
+    if not records:
+        return
+
+    t0 = records[0].time
+    stats = collections.defaultdict(collections.Counter)
+    redundant = collections.Counter()
+    redundant_time = collections.Counter()
+    last_read = {}  # (socket, name) -> value of the last read
+
+    for rec in records:
+        s, area, name = dec.decode(rec.addr)
+        key = "common" if s is None else "socket %d" % s
+        st = stats[key]
+        st["accesses"] += 1
+        st["bytes"] += rec.len
+        st["us"] += rec.duration
+        write = rec.flags & TRACE_WRITE
+        note = ""
+
+        if area == "reg":
+            if write:
+                # A write or command may change any register of the socket
+                for k in [k for k in last_read if k[0] == s]:
+                    del last_read[k]
+                if name == "Sn_CR":
+                    st["cmd " + COMMANDS.get(rec.value, "?")] += 1
+            elif rec.len <= 2 and name != "Sn_CR":
+                prev = last_read.get((s, name))
+                if prev == rec.value:
+                    redundant[(key, name)] += 1
+                    redundant_time[(key, name)] += rec.duration
+                    st["redundant"] += 1
+                    note = "  <- same as previous read"
+                last_read[(s, name)] = rec.value
+        else:
+            st[area + " bytes"] += rec.len
+            if write:
+                last_read.pop((s, "Sn_TX_FSR"), None)
+            else:
+                last_read.pop((s, "Sn_RX_RSR"), None)
+
+        if args.timeline and (args.socket is None or args.socket == s):
+            print("%10d %5dus  %-9s %s%s" % (
+                (rec.time - t0) & 0xFFFFFFFF, rec.duration, key,
+                describe(rec, name, area), note))
+
+    print()
+    print("%-10s %9s %9s %9s %9s %9s %9s" % (
+        "", "accesses", "bytes", "spi us", "tx bytes", "rx bytes",
+        "redundant"))
+    for key in sorted(stats, key=lambda k: (k != "common", k)):
+        st = stats[key]
+        print("%-10s %9d %9d %9d %9d %9d %9d" % (
+            key, st["accesses"], st["bytes"], st["us"], st["tx bytes"],
+            st["rx bytes"], st["redundant"]))
+        cmds = sorted((k[4:], v) for k, v in st.items()
+                      if k.startswith("cmd "))
+        if cmds:
+            print("%-10s commands: %s" % (
+                "", ", ".join("%s %d" % c for c in cmds)))
+
+    if redundant:
+        print()
+        print("Reads that returned the same value as the previous read:")
+        for (key, name), n in redundant.most_common():
+            print("  %-10s %-12s %6d reads %8d us" % (
+                key, name, n, redundant_time[(key, name)]))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Analyse a W5x00Trace dump.")
+    parser.add_argument("dump", help="binary dump, '-' for stdin")
+    parser.add_argument("--timeline", action="store_true",
+                        help="print every access")
+    parser.add_argument("--socket", type=int,
+                        help="only show this socket in the timeline")
+    args = parser.parse_args()
+
+    if args.dump == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+    try:
+        header, records = parse(data)
+    except ValueError as e:
+        sys.exit("%s: %s" % (args.dump, e))
+    analyse(header, records, args)
+
+
+if __name__ == "__main__":
+    main()
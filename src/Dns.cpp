@@ -42,6 +42,11 @@
 #define TRUNCATED        -3
 #define INVALID_RESPONSE -4
 
+// States of beginQuery() and pollQuery()
+#define QUERY_NONE       0
+#define QUERY_WAITING    1
+#define QUERY_NUMERIC    2
+
 void DNSClient::begin(const IPAddress& aDNSServer)
 {
 	iDNSServer = aDNSServer;
@@ -132,6 +137,60 @@ int DNSClient::getHostByName(const char* aHostname, IPAddress& aResult, uint16_t
 	return ret;
 }
 
+int DNSClient::beginQuery(const char* aHostname, uint16_t timeout)
+{
+	if (iQueryState == QUERY_WAITING) iUdp.stop();
+	iQueryState = QUERY_NONE;
+
+	// See if it's a numeric IP address
+	if (inet_aton(aHostname, iQueryAddress)) {
+		iQueryState = QUERY_NUMERIC;
+		return 1;
+	}
+
+	// Check we've got a valid DNS server to use
+	if (iDNSServer == INADDR_NONE) {
+		return INVALID_SERVER;
+	}
+
+	// Find a socket to use and send the request
+	if (iUdp.begin(1024+(millis() & 0xF)) != 1) return 0;
+	if (iUdp.beginPacket(iDNSServer, DNS_PORT) == 0 ||
+	  BuildRequest(aHostname) == 0 || iUdp.endPacket() == 0) {
+		iUdp.stop();
+		return 0;
+	}
+	iQueryState = QUERY_WAITING;
+	iQueryTimeout = timeout;
+	iQueryStart = millis();
+	return 1;
+}
+
+int DNSClient::pollQuery(IPAddress& aResult)
+{
+	int ret;
+
+	if (iQueryState == QUERY_NUMERIC) {
+		aResult = iQueryAddress;
+		iQueryState = QUERY_NONE;
+		return SUCCESS;
+	}
+	if (iQueryState != QUERY_WAITING) return TIMED_OUT;
+
+	if (iUdp.parsePacket() > 0) {
+		ret = (int16_t)ParseResponse(aResult);
+	} else if ((millis() - iQueryStart) > iQueryTimeout) {
+		ret = TIMED_OUT;
+	} else {
+		return 0;
+	}
+
+	// We're done with the socket now
+	iUdp.stop();
+	iQueryState = QUERY_NONE;
+	return ret;
+}
+
 uint16_t DNSClient::BuildRequest(const char* aName)
 {
 	// Build header
@@ -220,7 +279,11 @@ uint16_t DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
 		}
 		delay(50);
 	}
+	return ParseResponse(aAddress);
+}
 
+uint16_t DNSClient::ParseResponse(IPAddress& aAddress)
+{
 	// We've had a reply!
 	// Read the UDP header
 	//uint8_t header[DNS_HEADER_SIZE]; // Enough space to reuse for the DNS header
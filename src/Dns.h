@@ -11,7 +11,7 @@
 class DNSClient
 {
 public:
-	DNSClient(EthernetClass &ethernet) : iUdp(ethernet){}
+	DNSClient(EthernetClass &ethernet) : iUdp(ethernet), iQueryState(0){}
 
 	void begin(const IPAddress& aDNSServer);
 
@@ -31,13 +31,36 @@ public:
 	*/
 	int getHostByName(const char* aHostname, IPAddress& aResult, uint16_t timeout=5000);
 
+	/** Start resolving the given hostname without waiting for the answer.
+	    @param aHostname Name to be resolved
+	    @param timeout Milliseconds to wait for the answer
+	    @result 1 if the request was sent or aHostname is numeric, then call
+	            pollQuery() for the answer, else error code
+	*/
+	int beginQuery(const char* aHostname, uint16_t timeout=5000);
+	/** Check for the answer to beginQuery().
+	    @param aResult IPAddress structure to store the returned IP address
+	    @result 1 if aResult was set, 0 while still waiting, else error code
+	*/
+	int pollQuery(IPAddress& aResult);
+
+#if ETHERNET_ASYNC
+	// co_await dns.resolve(host), see EthernetScheduler
+	EthernetResolveWait resolve(const char* aHostname, uint16_t timeout=5000);
+#endif
+
 protected:
 	uint16_t BuildRequest(const char* aName);
 	uint16_t ProcessResponse(uint16_t aTimeout, IPAddress& aAddress);
+	uint16_t ParseResponse(IPAddress& aAddress);
 
 	IPAddress iDNSServer;
 	uint16_t iRequestId;
 	EthernetUDP iUdp;
+	uint8_t iQueryState; // of beginQuery()
+	uint16_t iQueryTimeout;
+	uint32_t iQueryStart;
+	IPAddress iQueryAddress; // numeric hostname given to beginQuery()
 };
 
 #endif
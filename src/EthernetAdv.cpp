@@ -26,10 +26,23 @@
 EthernetClass::EthernetClass(W5x00Class &w5x00){
 	_w5x00 = &w5x00;
 	//Create an array for the socket states just big enough for the number of sockets.
-	socketState = new socketstate_t[_w5x00->maxSockNum()];
+	socketState = new socketstate_t[_w5x00->maxSockNum()]();
+	_ownStorage = true;
+	_asyncSocket = _w5x00->maxSockNum();
+}
+
+EthernetClass::EthernetClass(W5x00Class &w5x00, socketstate_t *states, uint8_t sockets, DhcpClass *dhcp){
+	_w5x00 = &w5x00;
+	// The socket states are owned by the caller, use no more sockets than fit
+	_w5x00->limitSockNum(sockets);
+	socketState = states;
+	_dhcp = dhcp;
+	_ownStorage = false;
+	_asyncSocket = _w5x00->maxSockNum();
 }
 
 EthernetClass::~EthernetClass(){ 
+	if (!_ownStorage) return;
 	delete[] socketState; 
 	delete _dhcp;
 }
@@ -110,9 +123,21 @@ EthernetLinkStatus EthernetClass::linkStatus()
 	}
 }
 
+EthernetHardwareStatus EthernetClass::hardwareStatus()
+{
+	if (!_w5x00->initialized()) return EthernetNoHardware;
+	switch (_w5x00->chip()) {
+		case CHIP_W5100: return EthernetW5100;
+		case CHIP_W5200: return EthernetW5200;
+		case CHIP_W5500: return EthernetW5500;
+		default:         return EthernetNoHardware;
+	}
+}
+
 int EthernetClass::maintain()
 {
 	int rc = DHCP_CHECK_NONE;
+	keepAlive();
 	if (_dhcp != NULL) {
 		// we have a pointer to dhcp, use it
 		rc = _dhcp->checkLease();
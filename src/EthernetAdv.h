@@ -40,6 +40,43 @@
 #include "utility/W5100.h"
 #include "utility/W5200.h"
 #include "utility/W5500.h"
+#include "utility/W5x00Auto.h"
+#include "utility/W5x00Bus.h"
+#include "utility/W5x00Trace.h"
+#include "utility/EthernetQueue.h"
+
+// Set to 1 to use one EthernetClass from several tasks, see setLocking()
+// Changes the class layout, so set it as a global build flag.
+#ifndef ETHERNET_LOCKING
+#define ETHERNET_LOCKING 0
+#endif
+#if defined(__AVR__)
+#undef ETHERNET_LOCKING
+#define ETHERNET_LOCKING 0
+#endif
+
+#if ETHERNET_LOCKING && defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#elif ETHERNET_LOCKING && defined(ARDUINO_ARCH_RP2040)
+#include <pico/mutex.h>
+#endif
+
+// Coroutines (co_await client.connectAsync(...)) when the compiler supports
+// them, i.e. C++20.  Set to 0 to leave them out.
+#ifndef ETHERNET_ASYNC
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define ETHERNET_ASYNC 1
+#endif
+#endif
+#endif
+#ifndef ETHERNET_ASYNC
+#define ETHERNET_ASYNC 0
+#endif
+#if ETHERNET_ASYNC
+#include <coroutine>
+#endif
 
 enum EthernetLinkStatus {
 	Unknown,
@@ -47,18 +84,152 @@ enum EthernetLinkStatus {
 	LinkOFF
 };
 
+enum EthernetHardwareStatus {
+	EthernetNoHardware,
+	EthernetW5100,
+	EthernetW5200,
+	EthernetW5500
+};
+
+// Called when a background transfer started by socketBufferDataAsync()
+// or socketRecvAsync() has finished, len is the number of bytes transferred
+typedef void (*EthernetAsyncCallback)(uint8_t s, uint16_t len);
+
 class EthernetUDP;
 class EthernetClient;
 class EthernetServer;
 class DhcpClass;
+class DNSClient;
+#if ETHERNET_ASYNC
+class EthernetConnectWait;
+class EthernetReadWait;
+class EthernetWriteWait;
+class EthernetStopWait;
+class EthernetAcceptWait;
+class EthernetPacketWait;
+class EthernetResolveWait;
+#endif
+
+// When read data is given back to the chip (RX_RD and Sock_RECV), which
+// opens the receive window for the peer again.  See setRecvPolicy().
+enum EthernetRecvPolicy {
+	RecvFixed,    // after a fixed number of bytes
+	RecvFraction, // after a percentage of the socket buffer
+	RecvAdaptive  // after a multiple of the average read size
+};
+
+typedef struct {
+	uint32_t reads;   // reads that removed data from the receive buffer
+	uint32_t commits; // Sock_RECV commands
+	uint16_t window;  // current commit threshold in bytes
+} EthernetRecvStats;
+
+// Per-socket TCP options, see socketSetOptions().  A 0 keeps the default.
+typedef struct {
+	uint16_t mss;     // maximum segment size in bytes
+	uint8_t  tos;     // IP type of service, DSCP is tos >> 2
+	uint8_t  ttl;     // IP time to live (default 128)
+	uint16_t timeout; // ms a send may take before the socket is closed
+} EthernetSocketOptions;
+
+// Counters of one socket, see socketStats().  Only counted when the library
+// is built with ETHERNET_SOCKET_STATS set to 1, otherwise all zero.
+typedef struct {
+	uint32_t txBytes;     // bytes written to the transmit buffer
+	uint32_t rxBytes;     // bytes removed from the receive buffer
+	uint32_t sendCmds;    // Sock_SEND, Sock_SEND_MAC commands
+	uint32_t recvCmds;    // Sock_RECV commands
+	uint32_t sendWait;    // us spent waiting for SEND_OK
+	uint32_t txFull;      // sends that found the transmit buffer full
+	uint32_t spiOps;      // SPI reads and writes
+	uint32_t spiBytes;    // data bytes of those reads and writes
+	uint32_t connectTime; // us from Sock_CONNECT to ESTABLISHED, last connect
+	uint32_t closeTime;   // us from Sock_DISCON to CLOSED, last close
+} EthernetSocketStats;
+
+// Describes one datagram returned by EthernetUDP::parsePackets().
+// The payload is found at buffer[offset] up to buffer[offset + length - 1].
+typedef struct {
+	IPAddress remoteIP;
+	uint16_t remotePort;
+	uint16_t offset;
+	uint16_t length;
+} EthernetUDPPacketInfo;
+
+// Describes one Ethernet frame returned by EthernetRaw::readFrames().
+typedef struct {
+	uint16_t offset;
+	uint16_t length;
+} EthernetFrameInfo;
+
+#if ETHERNET_LOCKING
+// Locks of EthernetClass::setLocking(): the chip lock is held during every
+// chip transaction, the lock of a socket during every operation on it.
+class EthernetLocking {
+public:
+	virtual W5x00Lock* chipLock() = 0;
+	virtual void lockSocket(uint8_t s) = 0;
+	virtual void unlockSocket(uint8_t s) = 0;
+};
+
+// Makes a W5x00Lock of any type with lock() and unlock()
+template <class Mutex>
+class EthernetMutexLock : public W5x00Lock {
+public:
+	void lock() { _mutex.lock(); }
+	void unlock() { _mutex.unlock(); }
+private:
+	Mutex _mutex;
+};
+
+// One Mutex for the chip and one for each of the first N sockets, so tasks
+// that use different sockets only wait for each other's SPI transfers.
+// Sockets from N on use the chip lock, N = 0 is one lock for everything.
+// Mutex must be recursive, e.g. std::recursive_mutex, EthernetRTOSMutex or
+// EthernetPicoMutex.
+template <class Mutex, uint8_t N = 8>
+class EthernetLockPolicy : public EthernetLocking {
+public:
+	W5x00Lock* chipLock() { return &_chip; }
+	void lockSocket(uint8_t s) { if (s < N) _sockets[s].lock(); else _chip.lock(); }
+	void unlockSocket(uint8_t s) { if (s < N) _sockets[s].unlock(); else _chip.unlock(); }
+private:
+	EthernetMutexLock<Mutex> _chip;
+	Mutex _sockets[N ? N : 1];
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+// Recursive FreeRTOS mutex
+class EthernetRTOSMutex {
+public:
+	EthernetRTOSMutex() { _handle = xSemaphoreCreateRecursiveMutex(); }
+	void lock() { xSemaphoreTakeRecursive(_handle, portMAX_DELAY); }
+	void unlock() { xSemaphoreGiveRecursive(_handle); }
+private:
+	SemaphoreHandle_t _handle;
+};
+#elif defined(ARDUINO_ARCH_RP2040)
+// Recursive pico SDK mutex, also works between the two cores
+class EthernetPicoMutex {
+public:
+	EthernetPicoMutex() { recursive_mutex_init(&_mutex); }
+	void lock() { recursive_mutex_enter_blocking(&_mutex); }
+	void unlock() { recursive_mutex_exit(&_mutex); }
+private:
+	recursive_mutex_t _mutex;
+};
+#endif
+#endif
 
 class EthernetClass {
 private:
 	W5x00Class* _w5x00;
 	IPAddress _dnsServerAddress;
 	DhcpClass* _dhcp = nullptr;
+	bool _ownStorage; // socketState and _dhcp are allocated on the heap
 public:
 	// Constructor this will manly prepare the W5100 class.
+	// See EthernetStatic for a version that doesn't use the heap.
 	EthernetClass(W5x00Class &w5x00);
 
 	// Destructor
@@ -70,7 +241,7 @@ public:
 	int begin(uint8_t *mac, unsigned long timeout = 60000, unsigned long responseTimeout = 4000);
 	int maintain();
 	EthernetLinkStatus linkStatus();
-	// EthernetHardwareStatus hardwareStatus();
+	EthernetHardwareStatus hardwareStatus();
 
 	// Manual configuration
 	void begin(uint8_t *mac, IPAddress ip);
@@ -97,27 +268,69 @@ public:
 	uint8_t maxSocketNum();
 	bool hardwareInitialized() { return _w5x00->initialized(); }
 
+	// Keep the SPI bus for several socket calls, calls can be nested.
+	// See EthernetTransaction.
+	void beginTransaction() { _w5x00->beginTransaction(); }
+	void endTransaction() { _w5x00->endTransaction(); }
+
 	/*****************************************/
 	/*          Socket management            */
 	/*****************************************/
-private:
+protected:
 	
 	typedef struct {
 		uint16_t RX_RSR; // Number of bytes received
 		uint16_t RX_RD;  // Address to read
 		uint16_t TX_FSR; // Free space ready for transmit
-		uint8_t  RX_inc; // how much have we advanced RX_RD
+		uint16_t RX_inc; // how much have we advanced RX_RD
+		uint8_t  RX_policy; // EthernetRecvPolicy
+		uint16_t RX_value;  // threshold or percentage of the policy
+		uint16_t RX_avg;    // average read size, for RecvAdaptive
+		uint32_t RX_reads;
+		uint32_t RX_commits;
+		uint8_t  KA_time; // keep-alive interval in 5 s units, 0 = off
+		uint32_t KA_last; // millis() of the last keep-alive or send
+		uint16_t TX_timeout; // send deadline in ms, 0 = none
+		uint8_t  TX_opts;    // MSS, TOS or TTL were changed
+#if ETHERNET_SOCKET_STATS
+		EthernetSocketStats stats;
+		uint32_t connectStart; // micros() of Sock_CONNECT, 0 when done
+		uint32_t closeStart;   // micros() of Sock_DISCON, 0 when done
+#endif
 	} socketstate_t;	
 
+	// For EthernetStatic: use the socket states and DHCP client of the
+	// caller, which must be zeroed and outlive this object
+	EthernetClass(W5x00Class &w5x00, socketstate_t *states, uint8_t sockets, DhcpClass *dhcp);
+
+private:
+
 	// TODO: randomize this when not using DHCP, but how?
 	uint16_t local_port = 49152;  // 49152 to 65535
 
-	socketstate_t* socketState;		// Array defined in the constructor.  7 Bytes for each socket
+	socketstate_t* socketState;		// Array defined in the constructor.  29 Bytes for each socket
+#if ETHERNET_LOCKING
+	EthernetLocking* _locking = NULL;
+#endif
+	EthernetRecvPolicy _recvPolicy = RecvFixed;
+	uint16_t _recvValue = 250;
 
 	uint16_t getSnTX_FSR(uint8_t s);
 	uint16_t getSnRX_RSR(uint8_t s);
 	void write_data(uint8_t s, uint16_t offset, const uint8_t *data, uint16_t len);
 	void read_data(uint8_t s, uint16_t src, uint8_t *dst, uint16_t len);
+	void resetState(uint8_t s);
+	void recvAdvance(uint8_t s, uint16_t len);
+	void recvCommit(uint8_t s);
+	uint16_t recvWindow(uint8_t s);
+	void keepAlive();
+
+	// Background transfer in progress, see socketAsyncPoll()
+	uint8_t _asyncSocket;
+	bool _asyncRecv;
+	uint16_t _asyncPtr; // TX_WR after the transfer
+	uint16_t _asyncLen;
+	EthernetAsyncCallback _asyncCallback = nullptr;
 
 public:
 	//friend class EthernetClient;
@@ -127,6 +340,10 @@ public:
 	// Opens a socket(TCP or UDP or IP_RAW mode)
 	uint8_t socketBegin(uint8_t protocol, uint16_t port);
 	uint8_t socketBeginMulticast(uint8_t protocol, IPAddress ip,uint16_t port);
+	// Opens socket 0 in MACRAW mode, the only socket that supports it
+	uint8_t socketBeginMACRAW(bool macFilter);
+	// Opens a socket in IPRAW mode for the given IP protocol (IPPROTO::ICMP, ...)
+	uint8_t socketBeginIPRAW(uint8_t ipProtocol);
 	uint8_t socketStatus(uint8_t s);
 	// Close socket
 	void socketClose(uint8_t s);
@@ -138,23 +355,94 @@ public:
 	uint8_t socketListen(uint8_t s);
 	// Send data (TCP)
 	uint16_t socketSend(uint8_t s, const uint8_t * buf, uint16_t len);
+	// Send as much of buf as fits in the TX buffer without waiting, returns
+	// the bytes copied (0 if none fit or the socket is not connected).  The
+	// next send must wait until socketSendStatus() no longer returns -1.
+	uint16_t socketSendNoWait(uint8_t s, const uint8_t * buf, uint16_t len);
+	// return 1 once the chip has sent the data, 0 if the socket was closed
+	// or -1 while it is still being sent
+	int socketSendStatus(uint8_t s);
+	// Free space in the TX buffer, 0 if the socket can not send
 	uint16_t socketSendAvailable(uint8_t s);
 	// Receive data (TCP)
 	int socketRecv(uint8_t s, uint8_t * buf, int16_t len);
 	uint16_t socketRecvAvailable(uint8_t s);
+	// Read up to len bytes from the receive buffer without removing them
+	uint16_t socketRecvPeek(uint8_t s, uint8_t * buf, uint16_t len);
+	// Remove len bytes from the receive buffer with a single Sock_RECV command
+	void socketRecvSkip(uint8_t s, uint16_t len);
 	uint8_t socketPeek(uint8_t s);
+	// Policy for giving read data back to the chip, for sockets opened from now
+	// on (setRecvPolicy) or for one open socket (socketSetRecvPolicy).  value is
+	// the number of bytes for RecvFixed, the percentage of the socket buffer for
+	// RecvFraction and is not used for RecvAdaptive.  Default: RecvFixed, 250.
+	void setRecvPolicy(EthernetRecvPolicy policy, uint16_t value = 0);
+	void socketSetRecvPolicy(uint8_t s, EthernetRecvPolicy policy, uint16_t value = 0);
+	EthernetRecvStats socketRecvStats(uint8_t s);
+	// Send TCP keep-alive packets every seconds (rounded up to 5 s, max 1275)
+	// while the connection is idle, 0 turns it off.  The W5500 does this by
+	// itself, on the W5100 and W5200 they are sent from maintain().
+	void socketSetKeepAlive(uint8_t s, uint16_t seconds);
+#if ETHERNET_LOCKING
+	// Use this EthernetClass from several tasks with the locks of policy,
+	// set before the tasks start.  NULL turns locking off.  Background
+	// transfers must be started and finished by the same task.
+	void setLocking(EthernetLocking *policy);
+#endif
+	// Set MSS, TOS and TTL of a socket, before connecting or listening, and
+	// the time socketSend() waits for buffer space and the peer's ACK before
+	// it closes the socket.  The chip-wide retransmission timeout and count
+	// still apply and must allow at least this long.
+	void socketSetOptions(uint8_t s, const EthernetSocketOptions &options);
+	// Counters of socket s since begin() or socketResetStats(), or of the
+	// first max sockets in stats[], returns the number of sockets copied.
+	EthernetSocketStats socketStats(uint8_t s);
+	uint8_t socketStats(EthernetSocketStats *stats, uint8_t max);
+	void socketResetStats(uint8_t s);
 	// sets up a UDP datagram, the data for which will be provided by one
 	// or more calls to bufferData and then finally sent with sendUDP.
 	// return true if the datagram was successfully set up, or false if there was an error
 	bool socketStartUDP(uint8_t s, uint8_t* addr, uint16_t port);
+	// sets up an IPRAW datagram, like socketStartUDP but without a port
+	bool socketStartIPRAW(uint8_t s, uint8_t* addr);
 	// copy up to len bytes of data from buf into a UDP datagram to be
 	// sent later by sendUDP.  Allows datagrams to be built up from a series of bufferData calls.
 	// return Number of bytes successfully buffered
 	uint16_t socketBufferData(uint8_t s, uint16_t offset, const uint8_t* buf, uint16_t len);
+	// Like socketBufferData and socketRecv, but the data is transferred in the
+	// background when the chip has a W5x00AsyncTransfer backend.  Only one
+	// transfer per interface can be in progress, the interface keeps the SPI
+	// bus until socketAsyncPoll() returns true.  Don't make other calls on the
+	// interface before that, buf must stay valid until then.
+	// return Number of bytes that will be transferred, socketRecvAsync returns
+	// -1 or 0 like socketRecv when there is nothing to read, and -2 while the
+	// previous transfer is still in progress.
+	uint16_t socketBufferDataAsync(uint8_t s, uint16_t offset, const uint8_t* buf, uint16_t len);
+	int socketRecvAsync(uint8_t s, uint8_t * buf, int16_t len);
+	// Finish the background transfer when it is done.
+	// return true if no transfer is in progress anymore
+	bool socketAsyncPoll();
+	void setAsyncCallback(EthernetAsyncCallback callback) { _asyncCallback = callback; }
 	// Send a UDP datagram built up from a sequence of startUDP followed by one or more
 	// calls to bufferData.
+	// Sock_SEND_MAC can be used as cmd to skip ARP and send to the MAC address
+	// set with socketSetRemoteMAC.
 	// return true if the datagram was successfully sent, or false if there was an error
-	bool socketSendUDP(uint8_t s);
+	bool socketSendUDP(uint8_t s, SockCMD cmd = Sock_SEND);
+	// Start sending a UDP datagram without waiting for the chip to finish.
+	// The outcome must be collected with socketSendUDPStatus before the
+	// destination of the socket is changed.
+	void socketSendUDPNoWait(uint8_t s, SockCMD cmd = Sock_SEND);
+	// return 1 if the datagram was sent, 0 on timeout or -1 while it is still being sent
+	int socketSendUDPStatus(uint8_t s);
+	// Destination MAC address used by Sock_SEND_MAC.  After a successful
+	// Sock_SEND it holds the MAC address the chip resolved with ARP.
+	void socketSetRemoteMAC(uint8_t s, const uint8_t *mac);
+	void socketRemoteMAC(uint8_t s, uint8_t *mac);
+	// Receive all complete UDP datagrams that fit in buf with one bulk read, and
+	// release them from the receive buffer with a single Sock_RECV command.
+	// return Number of datagrams described in packets
+	uint8_t socketRecvUDPBatch(uint8_t s, uint8_t *buf, uint16_t len, EthernetUDPPacketInfo *packets, uint8_t maxPackets);
 	// Initialize the "random" source port number
 	void socketPortRand(uint16_t n);
 
@@ -164,17 +452,64 @@ public:
 
 };
 
+// Holds the SPI bus of an interface as long as it exists, so all socket
+// calls made in the meantime share one SPI transaction:
+//
+//   {
+//     EthernetTransaction t(Ethernet);
+//     if (client.connected() && client.available()) n = client.read(buf, len);
+//   }
+//
+// Don't keep it across calls that wait for the network, other users of
+// the SPI bus are locked out until it goes out of scope.
+class EthernetTransaction {
+private:
+	EthernetClass* _eth;
+	EthernetTransaction(const EthernetTransaction&);
+	EthernetTransaction& operator=(const EthernetTransaction&);
+public:
+	EthernetTransaction(EthernetClass &ethernet) { _eth = &ethernet; _eth->beginTransaction(); }
+	~EthernetTransaction() { _eth->endTransaction(); }
+};
+
 #define UDP_TX_PACKET_MAX_SIZE 24
 
+#ifndef ETHERNET_UDP_MAC_AGE
+#define ETHERNET_UDP_MAC_AGE 60000  // ms a learned MAC address is used before ARP is done again
+#endif
+
 class EthernetUDP : public UDP {
 private:
-	EthernetClass* _eth;
 	int16_t _port; // local port to listen on
 	IPAddress _remoteIP; // remote IP address for the incoming packet whilst it's being processed
 	uint16_t _remotePort; // remote port for the incoming packet whilst it's being processed
 	uint16_t _offset; // offset into the packet being sent
+	bool _asyncSend; // endPacket() does not wait for the packet to be sent
+	int8_t _sendStatus; // outcome of the last packet sent, -1 while still sending
+	uint32_t _sendTimeouts; // number of packets that could not be sent
+	IPAddress _sendIP; // destination of the packet being built
+	uint16_t _sendPort;
+	IPAddress _inflightIP; // destination of the last packet handed to the chip
+	bool _sendMAC; // the last packet handed to the chip uses the pinned MAC address
+	bool _learnMAC; // pin the MAC address resolved for the next destination
+	bool _pinnedValid;
+	bool _pinnedLearned; // _pinnedMAC was learned and expires
+	uint32_t _pinnedTime; // when _pinnedMAC was learned
+	IPAddress _pinnedIP;
+	uint8_t _pinnedMAC[6];
+	uint8_t *_txBuffer; // host side buffer to collect the packet being sent
+	uint16_t _txSize;
+	uint16_t _txLen;
+	const uint8_t *_txData; // packet data given to beginPacket(), sent as is
+	uint16_t _txDataLen;
+	bool _txTruncated; // part of the packet did not fit in the socket buffer
+
+	void sendDone(int ok);
+	void bufferData(const uint8_t *buffer, uint16_t size);
+	void flushPacketBuffer();
 
 protected:
+	EthernetClass* _eth;
 	uint8_t sockindex;
 	uint16_t _remaining; // remaining bytes of incoming packet yet to be processed
 
@@ -194,9 +529,39 @@ public:
 	// Start building up a packet to send to the remote host specific in host and port
 	// Returns 1 if successful, 0 if there was a problem resolving the hostname or port
 	virtual int beginPacket(const char *host, uint16_t port);
+	// Send len bytes of data as the packet to the remote host specific in ip and port.
+	// The data is copied to the chip at endPacket(), it must not change before that.
+	// Returns 1 if successful, 0 if there was a problem with the supplied IP address or port
+	int beginPacket(IPAddress ip, uint16_t port, const uint8_t *data, uint16_t len);
+	// Collect the data written to a packet in buffer and copy it to the chip with
+	// a single transfer at endPacket(), instead of a transfer for every write().
+	// size is limited to the socket buffer size.  Pass NULL to stop using a buffer.
+	void setPacketBuffer(uint8_t *buffer, uint16_t size);
 	// Finish off this packet and send it
 	// Returns 1 if the packet was sent successfully, 0 if there was an error
+	// or not all of its data fitted in the socket buffer
 	virtual int endPacket();
+	// Let endPacket() return as soon as the chip starts sending the packet.
+	// The next packet can be collected in the packet buffer while it is sent,
+	// but is only copied to the chip once it has gone.  Its outcome is
+	// collected by the next write(), endPacket() or pollSend().
+	void setAsyncSend(bool async) { _asyncSend = async; }
+	// Returns 1 if the last packet was sent, 0 if sending it timed out,
+	// or -1 if it is still being sent
+	int pollSend();
+	// Number of packets that timed out (e.g. no ARP reply) since begin()
+	uint32_t sendTimeouts() { return _sendTimeouts; }
+	// Pin the MAC address of a peer.  Packets to ip are sent with Sock_SEND_MAC
+	// directly to mac, so the chip never has to ARP for it.  The chip can not
+	// tell whether mac is still right, it stays pinned until clearRemoteMAC().
+	void setRemoteMAC(IPAddress ip, const uint8_t *mac);
+	// Pin the MAC address the chip resolves for the next unicast packet
+	// that is sent successfully.  A learned address is resolved with ARP
+	// again after ETHERNET_UDP_MAC_AGE ms, so a peer that moved is found.
+	void learnRemoteMAC(bool learn = true) { _learnMAC = learn; }
+	// Returns true and fills mac if a MAC address is pinned for ip
+	bool remoteMAC(IPAddress ip, uint8_t *mac);
+	void clearRemoteMAC() { _pinnedValid = false; }
 	// Write a single byte into the packet
 	virtual size_t write(uint8_t);
 	// Write size bytes from buffer into the packet
@@ -207,6 +572,16 @@ public:
 	// Start processing the next available incoming packet
 	// Returns the size of the packet in bytes, or 0 if no packets are available
 	virtual int parsePacket();
+#if ETHERNET_ASYNC
+	// co_await parsePacketAsync(): parsePacket() once a packet has arrived,
+	// 0 after timeout ms (0 waits forever).  See EthernetScheduler.
+	EthernetPacketWait parsePacketAsync(uint32_t timeout = 0);
+#endif
+	// Read all complete packets waiting in the receive buffer that fit in buffer,
+	// and describe each of them in packets (at most maxPackets).
+	// Returns the number of packets, or 0 if no packets are available.
+	// A packet larger than buffer is left in place, use parsePacket() to read it.
+	int parsePackets(uint8_t *buffer, size_t size, EthernetUDPPacketInfo *packets, uint8_t maxPackets);
 	// Number of bytes remaining in the current packet
 	virtual int available();
 	// Read a single byte from the current packet
@@ -228,6 +603,245 @@ public:
 	virtual uint16_t localPort() { return _port; }
 };
 
+#define ETHERNET_MULTICAST_MAX_GROUPS 4
+#define ETHERNET_MULTICAST_LINK_INTERVAL 500 // ms between link checks in maintain()
+
+enum EthernetIGMPVersion {
+	IGMPv1,
+	IGMPv2		// Leave messages are sent when a group is left
+};
+
+// Receives several multicast groups, each on its own hardware socket.
+// parsePacket() returns the packets of all groups in turn, groupIP() tells
+// which group the current packet was sent to.
+class EthernetMulticast : public EthernetUDP {
+private:
+	typedef struct {
+		IPAddress ip;
+		uint16_t port;
+		uint8_t sockindex;
+		EthernetIGMPVersion version;
+	} group_t;
+
+	group_t _groups[ETHERNET_MULTICAST_MAX_GROUPS];
+	uint8_t _numGroups;
+	uint8_t _current; // group of the packet being processed
+	EthernetLinkStatus _link;
+	unsigned long _lastLinkCheck;
+
+	uint8_t openGroup(group_t &group);
+	uint8_t openPending();
+
+public:
+	EthernetMulticast(EthernetClass &ethernet);
+
+	// Join a group, a socket is used for every group.
+	// Returns 1 if successful, 0 if there are no sockets or groups available
+	uint8_t join(IPAddress group, uint16_t port, EthernetIGMPVersion version = IGMPv2);
+	// Leave a group, closing its socket (the chip sends a leave message for IGMPv2)
+	void leave(IPAddress group);
+	// Leave all groups
+	virtual void stop();
+	// Re-open all group sockets, which makes the chip send new join messages.
+	// Returns the number of groups joined again, the others stay pending.
+	uint8_t rejoin();
+	// Call regularly, re-joins all groups when the link comes back up and
+	// retries the groups whose socket could not be opened then.
+	// Returns the number of groups that were re-joined.
+	int maintain();
+
+	virtual int parsePacket();
+	uint8_t groupCount() { return _numGroups; }
+	// Group the current packet was sent to
+	IPAddress groupIP();
+};
+
+// Sends and receives complete Ethernet frames on socket 0 in MACRAW mode.
+// Every frame includes the Ethernet header (destination and source MAC,
+// EtherType), the chip adds the preamble and the CRC.
+class EthernetRaw {
+private:
+	EthernetClass* _eth;
+	uint8_t sockindex;
+
+public:
+	EthernetRaw(EthernetClass &ethernet);
+
+	// Open socket 0 in MACRAW mode, it must not be in use.
+	// With macFilter only frames for our MAC address, broadcast and multicast
+	// are received (W5200 and W5500).
+	// Returns 1 if successful, 0 if socket 0 is in use or the chip can't
+	// filter
+	uint8_t begin(bool macFilter = false);
+	void stop();
+
+	// Read the next frame into buffer.  Only its length and the part of the
+	// frame that fits in buffer are read, a larger frame is truncated.
+	// Returns the number of bytes stored, or 0 if no frame is available
+	int readFrame(uint8_t *buffer, uint16_t size);
+	// Read all complete frames waiting that fit in buffer, and describe each
+	// of them in frames (at most maxFrames).  Returns the number of frames.
+	int readFrames(uint8_t *buffer, uint16_t size, EthernetFrameInfo *frames, uint8_t maxFrames);
+	// Send a frame.  Returns 1 if the frame was sent, 0 if there was an error
+	int writeFrame(const uint8_t *frame, uint16_t len);
+};
+
+#define ETHERNET_PING_MAX_TARGETS 4
+#define ETHERNET_PING_MAX_INFLIGHT 4
+#define ETHERNET_PING_BUCKETS 8
+
+// Round trip statistics of one ping target, times are in microseconds
+typedef struct {
+	IPAddress ip;
+	uint32_t sent;
+	uint32_t received;
+	uint32_t lost;
+	uint32_t lastRTT;
+	uint32_t minRTT;
+	uint32_t avgRTT;
+	uint32_t maxRTT;
+	uint32_t jitter; // mean deviation between consecutive round trips (RFC 3550)
+	uint16_t histogram[ETHERNET_PING_BUCKETS]; // see EthernetPing::bucketLimit()
+} EthernetPingStats;
+
+// Sends ICMP echo requests from an IPRAW socket and collects the replies
+// without waiting for them.  Several requests can be in flight at once.
+class EthernetPing {
+private:
+	typedef struct {
+		uint8_t target;	// index in _stats, ETHERNET_PING_MAX_TARGETS if unused
+		uint16_t seq;
+		uint32_t sentMicros;
+	} inflight_t;
+
+	EthernetClass* _eth;
+	uint8_t sockindex;
+	uint16_t _id;
+	uint16_t _seq;
+	uint32_t _timeout; // us
+	bool _sending; // the last request is still being sent by the chip
+	uint8_t _sendingSlot;
+	uint8_t _numTargets;
+	EthernetPingStats _stats[ETHERNET_PING_MAX_TARGETS];
+	inflight_t _inflight[ETHERNET_PING_MAX_INFLIGHT];
+
+	void reply(uint8_t slot, uint32_t rtt);
+	void lost(uint8_t slot);
+
+public:
+	EthernetPing(EthernetClass &ethernet);
+
+	// Returns 1 if successful, 0 if there are no sockets available
+	uint8_t begin();
+	void stop();
+
+	// Send an echo request to target.  Returns 1 if the request was sent, 0 if
+	// there are too many requests in flight or targets, or the previous
+	// request is still being sent (e.g. waiting for ARP).
+	int send(IPAddress target);
+	// Process the received replies and expired requests, call this regularly.
+	// Returns the number of replies processed.
+	int poll();
+	// Time after which a request is counted as lost, default 1000 ms
+	void setTimeout(uint32_t milliseconds) { _timeout = milliseconds * 1000; }
+	uint8_t inFlight();
+
+	// Statistics of target, or NULL if no requests were sent to it
+	EthernetPingStats* stats(IPAddress target);
+	void resetStats();
+	// Upper limit (exclusive) of histogram bucket b, the last bucket has no limit
+	static uint32_t bucketLimit(uint8_t b);
+
+	// Internet checksum (RFC 1071) of len bytes
+	static uint16_t checksum(const uint8_t *data, uint16_t len);
+};
+
+#ifndef ETHERNET_TASK_REQUESTS
+#define ETHERNET_TASK_REQUESTS 16   // size of the request queue, a power of two
+#endif
+#ifndef ETHERNET_TASK_COMPLETIONS
+#define ETHERNET_TASK_COMPLETIONS 8 // size of a completion queue, a power of two
+#endif
+#define ETHERNET_TASK_PENDING 8     // requests worked on at the same time
+#define ETHERNET_TASK_CLIENTS 4     // completion queues
+
+enum EthernetTaskOp {
+	NetConnect, // connect to ip:port, result 1 and the socket, or 0
+	NetListen,  // listen on port, result 1 and the socket, or 0
+	NetAccept,  // wait for a connection on a listening socket, result 1 or 0
+	NetSend,    // send len bytes of data, result the number of bytes sent
+	NetRecv,    // read at most len bytes into data once there are some,
+	            // result the number of bytes read, 0 if the peer closed
+	NetClose    // disconnect and close, result 1
+};
+
+// A request to EthernetTask and, once done, its completion.  data must stay
+// valid until the completion is received.
+typedef struct {
+	uint8_t op;       // EthernetTaskOp
+	uint8_t socket;   // in for Accept, Send, Recv and Close, out for Connect and Listen
+	uint8_t client;   // completion queue, see EthernetTask::attach()
+	uint8_t ip[4];
+	uint16_t port;
+	uint16_t len;
+	uint8_t *data;
+	uint32_t timeout; // ms, 0 for none.  A Send that times out gives the
+	                  // bytes sent so far, Connect and Close always time out
+	uint32_t tag;     // returned unchanged with the completion
+	int32_t result;   // Accept and Recv give -1 when they time out
+} EthernetRequest;
+
+typedef EthernetSPSCQueue<EthernetRequest, ETHERNET_TASK_COMPLETIONS> EthernetCompletionQueue;
+
+// Lets one task own the chip while other tasks hand it requests through
+// lock-free queues and get completions back, so no task but the network
+// task waits for the SPI bus.  The network task calls poll() in a loop;
+// every other task attaches a completion queue of its own and calls the
+// request functions, which only queue the request.  Requests on one socket
+// are done in the order they were made.
+class EthernetTask {
+private:
+	typedef struct {
+		EthernetRequest req;
+		uint32_t start;  // millis() when work on the request started
+		uint32_t order;  // requests on one socket are done oldest first
+		uint8_t state;
+		bool used;
+	} pending_t;
+
+	EthernetClass* _eth;
+	EthernetMPSCQueue<EthernetRequest, ETHERNET_TASK_REQUESTS> _requests;
+	EthernetCompletionQueue* _clients[ETHERNET_TASK_CLIENTS];
+	pending_t _pending[ETHERNET_TASK_PENDING];
+	uint32_t _order;
+	uint32_t _connectTimeout;
+
+	bool step(pending_t &p);
+	bool waiting(const pending_t &p);
+
+public:
+	EthernetTask(EthernetClass &ethernet);
+
+	// Set up before the tasks start.  Returns the client number to use in
+	// requests, or -1 if there are ETHERNET_TASK_CLIENTS queues already.
+	int attach(EthernetCompletionQueue &queue);
+	// Time after which a connect fails, default 10000 ms
+	void setConnectTimeout(uint32_t milliseconds) { _connectTimeout = milliseconds; }
+
+	// Any task: queue a request.  false if the request queue is full.
+	bool submit(const EthernetRequest &request);
+	bool connect(uint8_t client, IPAddress ip, uint16_t port, uint32_t tag = 0);
+	bool listen(uint8_t client, uint16_t port, uint32_t tag = 0);
+	bool accept(uint8_t client, uint8_t s, uint32_t timeout = 0, uint32_t tag = 0);
+	bool send(uint8_t client, uint8_t s, const uint8_t *data, uint16_t len, uint32_t timeout = 0, uint32_t tag = 0);
+	bool recv(uint8_t client, uint8_t s, uint8_t *data, uint16_t len, uint32_t timeout = 0, uint32_t tag = 0);
+	bool close(uint8_t client, uint8_t s, uint32_t tag = 0);
+
+	// Network task only: take new requests and work on the ones in progress,
+	// all in one SPI transaction.  Returns the number of completions.
+	int poll();
+};
+
 class EthernetClient : public Client {
 public:
 	EthernetClient(EthernetClass &ethernet);
@@ -256,8 +870,45 @@ public:
 	virtual IPAddress remoteIP();
 	virtual uint16_t remotePort();
 	virtual void setConnectionTimeout(uint16_t timeout) { _timeout = timeout; }
+	// connect() without waiting: returns 1 if the connection is being made,
+	// 0 if there is no socket.  pollConnect() then returns 1 once connected,
+	// 0 if it failed or timed out, or -1 while still connecting.
+	int beginConnect(IPAddress ip, uint16_t port);
+	int pollConnect();
+	// stop() without waiting: pollStop() returns 1 once the connection is
+	// closed, 0 if it had to be closed forcibly, or -1 while still closing.
+	void beginStop();
+	int pollStop();
+	// write() without waiting: beginWrite() copies as much of buf as fits in
+	// the socket buffer and starts sending it, returns the bytes copied.
+	// pollWrite() then returns 1 once they are sent, 0 if the connection
+	// was closed, or -1 while still sending.
+	size_t beginWrite(const uint8_t *buf, size_t size);
+	int pollWrite();
+#if ETHERNET_ASYNC
+	// Awaitables, see EthernetScheduler.  connectAsync() and stopAsync()
+	// give the result of pollConnect() and pollStop().  readAsync() waits
+	// for data and gives the bytes read, 0 if the peer closed the connection
+	// or -1 after timeout ms.  writeAsync() writes as buffer space frees up
+	// and gives the bytes written.  A timeout of 0 waits forever.
+	EthernetConnectWait connectAsync(IPAddress ip, uint16_t port);
+	EthernetReadWait readAsync(uint8_t *buf, size_t size, uint32_t timeout = 0);
+	EthernetWriteWait writeAsync(const uint8_t *buf, size_t size, uint32_t timeout = 0);
+	EthernetStopWait stopAsync();
+#endif
+	// See EthernetClass::setRecvPolicy(), only for a connected client
+	void setRecvPolicy(EthernetRecvPolicy policy, uint16_t value = 0);
+	EthernetRecvStats recvStats();
+	// See EthernetClass::socketSetKeepAlive()
+	void setKeepAlive(uint16_t seconds);
+	// See EthernetClass::socketSetOptions(), used by every connect()
+	void setSocketOptions(const EthernetSocketOptions &options);
+	// Make the next connect() over ethernet, keeping the connection timeout
+	// and socket options.  A connection that is still open is stopped.
+	void setInterface(EthernetClass &ethernet);
 
 	//friend class EthernetServer;
+	friend class EthernetRouter;
 
 	using Print::write;
 
@@ -265,6 +916,9 @@ private:
 	EthernetClass* _eth;
 	uint8_t _sockindex; // MAX_SOCK_NUM means client not in use
 	uint16_t _timeout;
+	uint32_t _start; // millis() of beginConnect() or beginStop()
+	bool _useOptions;
+	EthernetSocketOptions _options;
 };
 
 class EthernetServer : public Server {
@@ -272,6 +926,8 @@ private:
 	EthernetClass* _eth;
 	uint16_t _port;
 	uint8_t _sockindex; // MAX_SOCK_NUM means client not in use
+	bool _useOptions;
+	EthernetSocketOptions _options;
 
 public:
 	EthernetServer(EthernetClass &ethernet, uint16_t port);
@@ -282,10 +938,320 @@ public:
 	virtual size_t write(uint8_t);
 	virtual size_t write(const uint8_t *buf, size_t size);
 	virtual operator bool();
+	// See EthernetClass::socketSetOptions(), used for the listening socket
+	// and so for the clients it accepts
+	void setSocketOptions(const EthernetSocketOptions &options);
+#if ETHERNET_ASYNC
+	// co_await acceptAsync(): the next client that connects, or a client that
+	// is not connected after timeout ms (0 waits forever).
+	EthernetAcceptWait acceptAsync(uint32_t timeout = 0);
+#endif
 	using Print::write;
 	//void statusreport();
 };
 
+#if ETHERNET_ASYNC
+class EthernetScheduler;
+
+// A coroutine run by EthernetScheduler: a function returning
+// EthernetCoroutine that waits with co_await on the awaitables below.
+// Start it with EthernetScheduler::start(), or co_await it from another
+// coroutine to run it to the end.
+class EthernetCoroutine {
+public:
+	struct promise_type;
+	typedef std::coroutine_handle<promise_type> handle_t;
+
+	struct promise_type {
+		EthernetScheduler *scheduler = nullptr;
+		std::coroutine_handle<> caller; // resumed at the end, if awaited
+
+		struct final_awaiter {
+			bool await_ready() noexcept { return false; }
+			std::coroutine_handle<> await_suspend(handle_t h) noexcept;
+			void await_resume() noexcept { }
+		};
+
+		EthernetCoroutine get_return_object() { return EthernetCoroutine(handle_t::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		final_awaiter final_suspend() noexcept { return {}; }
+		void return_void() { }
+		void unhandled_exception() { }
+	};
+
+	EthernetCoroutine(EthernetCoroutine &&other) : _handle(other._handle) { other._handle = nullptr; }
+	~EthernetCoroutine() { if (_handle) _handle.destroy(); }
+
+	bool await_ready() { return !_handle || _handle.done(); }
+	std::coroutine_handle<> await_suspend(handle_t caller) {
+		_handle.promise().scheduler = caller.promise().scheduler;
+		_handle.promise().caller = caller;
+		return _handle;
+	}
+	void await_resume() { }
+
+private:
+	friend class EthernetScheduler;
+	explicit EthernetCoroutine(handle_t h) : _handle(h) { }
+	EthernetCoroutine(const EthernetCoroutine&);
+	EthernetCoroutine& operator=(const EthernetCoroutine&);
+
+	handle_t _handle;
+};
+
+// Base of the awaitables: the coroutine is resumed by EthernetScheduler::poll()
+// once ready() returns true.  Derive from it to wait for anything else.
+class EthernetWait {
+public:
+	bool await_ready() { return ready(); }
+	void await_suspend(EthernetCoroutine::handle_t h);
+
+protected:
+	EthernetWait() : _start(millis()), _next(nullptr) { }
+	virtual bool ready() = 0;
+	bool expired(uint32_t timeout) { return timeout && millis() - _start >= timeout; }
+
+	uint32_t _start; // millis() when the awaitable was made
+
+private:
+	friend class EthernetScheduler;
+	EthernetWait *_next;
+	std::coroutine_handle<> _handle;
+};
+
+// Runs any number of coroutines in turn from loop(), so many connections
+// can be handled without blocking and without state machines:
+//
+//   EthernetCoroutine echo(EthernetClient client) {
+//     uint8_t buf[64];
+//     int n;
+//     while ((n = co_await client.readAsync(buf, sizeof(buf))) > 0) {
+//       co_await client.writeAsync(buf, n);
+//     }
+//     co_await client.stopAsync();
+//   }
+//   void loop() {
+//     scheduler.poll();
+//   }
+//
+// The coroutines only run inside start() and poll(), so they don't need
+// ETHERNET_LOCKING.  The awaitables make their first step (e.g. sending the
+// connect) when they are made and must be awaited right away.
+class EthernetScheduler {
+public:
+	EthernetScheduler() : _first(nullptr), _last(nullptr), _running(0) { }
+
+	// Run the coroutine until its first co_await that has to wait
+	void start(EthernetCoroutine coroutine);
+	// Resume the coroutines that can go on, returns how many were resumed
+	int poll();
+	// Number of started coroutines that have not finished
+	uint16_t running() { return _running; }
+
+private:
+	friend class EthernetWait;
+	friend class EthernetCoroutine;
+	void wait(EthernetWait *w);
+
+	EthernetWait *_first;
+	EthernetWait *_last;
+	uint16_t _running;
+};
+
+// co_await EthernetSleep(ms) lets the other coroutines run for ms milliseconds
+class EthernetSleep : public EthernetWait {
+public:
+	EthernetSleep(uint32_t ms) : _ms(ms) { }
+	void await_resume() { }
+protected:
+	bool ready() { return millis() - _start >= _ms; }
+private:
+	uint32_t _ms;
+};
+
+class EthernetConnectWait : public EthernetWait {
+public:
+	EthernetConnectWait(EthernetClient &client, IPAddress ip, uint16_t port);
+	int await_resume() { return _result; }
+protected:
+	bool ready();
+private:
+	EthernetClient *_client;
+	int _result;
+};
+
+class EthernetReadWait : public EthernetWait {
+public:
+	EthernetReadWait(EthernetClient &client, uint8_t *buf, size_t size, uint32_t timeout)
+		: _client(&client), _buf(buf), _size(size), _timeout(timeout), _result(-1) { }
+	int await_resume() { return _result; }
+protected:
+	bool ready();
+private:
+	EthernetClient *_client;
+	uint8_t *_buf;
+	size_t _size;
+	uint32_t _timeout;
+	int _result;
+};
+
+class EthernetWriteWait : public EthernetWait {
+public:
+	EthernetWriteWait(EthernetClient &client, const uint8_t *buf, size_t size, uint32_t timeout)
+		: _client(&client), _buf(buf), _size(size), _timeout(timeout), _result(0), _sending(false) { }
+	size_t await_resume() { return _result; }
+protected:
+	bool ready();
+private:
+	EthernetClient *_client;
+	const uint8_t *_buf;
+	size_t _size;
+	uint32_t _timeout;
+	size_t _result;
+	bool _sending; // waiting for pollWrite()
+};
+
+class EthernetStopWait : public EthernetWait {
+public:
+	EthernetStopWait(EthernetClient &client) : _client(&client), _result(1) { client.beginStop(); }
+	int await_resume() { return _result; }
+protected:
+	bool ready() { return (_result = _client->pollStop()) >= 0; }
+private:
+	EthernetClient *_client;
+	int _result;
+};
+
+class EthernetAcceptWait : public EthernetWait {
+public:
+	EthernetAcceptWait(EthernetServer &server, EthernetClass &ethernet, uint32_t timeout)
+		: _server(&server), _client(ethernet), _timeout(timeout) { }
+	EthernetClient await_resume() { return _client; }
+protected:
+	bool ready();
+private:
+	EthernetServer *_server;
+	EthernetClient _client;
+	uint32_t _timeout;
+};
+
+class EthernetPacketWait : public EthernetWait {
+public:
+	EthernetPacketWait(EthernetUDP &udp, uint32_t timeout) : _udp(&udp), _timeout(timeout), _result(0) { }
+	int await_resume() { return _result; }
+protected:
+	bool ready();
+private:
+	EthernetUDP *_udp;
+	uint32_t _timeout;
+	int _result;
+};
+
+// co_await dns.resolve(host) gives the address, or INADDR_NONE if the name
+// could not be resolved
+class EthernetResolveWait : public EthernetWait {
+public:
+	EthernetResolveWait(DNSClient &dns, const char *host, uint16_t timeout);
+	IPAddress await_resume() { return _result == 1 ? _ip : INADDR_NONE; }
+protected:
+	bool ready();
+private:
+	DNSClient *_dns;
+	IPAddress _ip;
+	int _result;
+};
+
+inline std::coroutine_handle<> EthernetCoroutine::promise_type::final_awaiter::await_suspend(handle_t h) noexcept
+{
+	// An awaited coroutine goes back to its caller, which destroys it.  A
+	// started one is gone when it ends.
+	std::coroutine_handle<> caller = h.promise().caller;
+	if (caller) return caller;
+	EthernetScheduler *scheduler = h.promise().scheduler;
+	h.destroy();
+	if (scheduler) scheduler->_running--;
+	return std::noop_coroutine();
+}
+
+inline void EthernetWait::await_suspend(EthernetCoroutine::handle_t h)
+{
+	_handle = h;
+	h.promise().scheduler->wait(this);
+}
+#endif
+
+#define ETHERNET_ROUTER_MAX_ROUTES 8
+#define ETHERNET_ROUTER_MAX_INTERFACES 4
+#define ETHERNET_ROUTER_LINK_INTERVAL 500 // ms between link checks in maintain()
+
+// One entry of the routing table of EthernetRouter
+typedef struct {
+	IPAddress prefix;
+	uint8_t length;    // prefix length in bits, 0 for a default route
+	uint8_t metric;    // of the routes with the longest prefix the lowest is used
+	uint8_t interface; // index of the interface in the router
+	bool subnet;       // prefix and length follow the IP address and subnet
+	                   // mask of the interface, see addSubnetRoute()
+} EthernetRoute;
+
+// Decides which of several EthernetClass interfaces reaches a destination.
+// Of the routes that match, the one with the longest prefix wins, then the
+// one with the lowest metric.  Routes over an interface whose link is down
+// are skipped, so traffic fails over to the next best route at most
+// ETHERNET_ROUTER_LINK_INTERVAL ms after the link went down (when
+// maintain() is called regularly).  connect() also tries the next best
+// interface when a connection fails.
+class EthernetRouter {
+private:
+	typedef struct {
+		EthernetClass* eth;
+		bool up;
+	} interface_t;
+
+	EthernetRoute _routes[ETHERNET_ROUTER_MAX_ROUTES];
+	uint8_t _numRoutes;
+	interface_t _interfaces[ETHERNET_ROUTER_MAX_INTERFACES];
+	uint8_t _numInterfaces;
+	uint32_t _lastLinkCheck;
+	uint16_t _timeout;
+
+	int addInterface(EthernetClass &ethernet);
+	int select(IPAddress ip, uint8_t skip);
+
+public:
+	EthernetRouter();
+
+	// Returns 1 if the route was added, 0 if the table is full or there are
+	// more than ETHERNET_ROUTER_MAX_INTERFACES interfaces
+	int addRoute(IPAddress prefix, uint8_t length, EthernetClass &ethernet, uint8_t metric = 0);
+	// Route to the subnet the interface is on, which follows DHCP
+	int addSubnetRoute(EthernetClass &ethernet, uint8_t metric = 0);
+	int addDefaultRoute(EthernetClass &ethernet, uint8_t metric = 0) { return addRoute(IPAddress(0, 0, 0, 0), 0, ethernet, metric); }
+	void removeRoutes(EthernetClass &ethernet);
+	void clear();
+	uint8_t routeCount() { return _numRoutes; }
+	const EthernetRoute* getRoute(uint8_t index) { return index < _numRoutes ? &_routes[index] : NULL; }
+
+	// The interface to reach ip over, or NULL if no route with a link matches
+	EthernetClass* route(IPAddress ip);
+	// Connect client over the best route to ip.  client is moved to the
+	// interface that was used, keeping its socket options and connection
+	// timeout.  If connecting fails the next best interface is tried, each
+	// one for at most the connection timeout.
+	// Returns 1 if connected, 0 if no route worked.
+	int connect(EthernetClient &client, IPAddress ip, uint16_t port);
+	// Connection timeout for each interface connect() tries, instead of the
+	// one of the client, which is restored afterwards.  0 (the default) uses
+	// the client's.
+	void setConnectionTimeout(uint16_t timeout) { _timeout = timeout; }
+
+	// Check the links, call this regularly.  Returns the number of
+	// interfaces whose link went up or down.
+	int maintain();
+	// false if the link of ethernet was down at the last check
+	bool linkUp(EthernetClass &ethernet);
+};
+
 // Next class is used by EthernetClass when you do not supply an IP yourself. 
 // Ther is no readon to create your own instance of this class. 
 class DhcpClass {
@@ -337,4 +1303,21 @@ public:
 	int checkLease();
 };
 
+// EthernetClass without heap allocation: the socket states and the DHCP
+// client are members, sized for N sockets.  The chip uses at most N sockets
+// (see W5x00Class::limitSockNum()), 8 fits every chip.
+//
+//   W5500Class w5500(SPI, 10);
+//   EthernetStatic<4> Ethernet(w5500);
+template <uint8_t N = 8>
+class EthernetStatic : public EthernetClass {
+public:
+	EthernetStatic(W5x00Class &w5x00) : EthernetClass(w5x00, _states, N, &_dhcpClient), _states(), _dhcpClient(*this) { }
+
+private:
+	static_assert(N > 0 && N <= 8, "N must be 1 to 8 sockets");
+	socketstate_t _states[N];
+	DhcpClass _dhcpClient;
+};
+
 #endif
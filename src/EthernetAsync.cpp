@@ -0,0 +1,178 @@
+/* Copyright 2026 Lode Van Dyck
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+#include "Dns.h"
+
+#if ETHERNET_ASYNC
+
+void EthernetScheduler::start(EthernetCoroutine coroutine)
+{
+	EthernetCoroutine::handle_t h = coroutine._handle;
+	if (!h) return;
+	coroutine._handle = nullptr;
+	h.promise().scheduler = this;
+	_running++;
+	h.resume();
+}
+
+void EthernetScheduler::wait(EthernetWait *w)
+{
+	w->_next = nullptr;
+	if (_last) {
+		_last->_next = w;
+	} else {
+		_first = w;
+	}
+	_last = w;
+}
+
+int EthernetScheduler::poll()
+{
+	int resumed = 0;
+	// Coroutines that wait again while being resumed go on the new list
+	EthernetWait *w = _first;
+	_first = _last = nullptr;
+	while (w) {
+		EthernetWait *next = w->_next;
+		if (w->ready()) {
+			w->_handle.resume();
+			resumed++;
+		} else {
+			wait(w);
+		}
+		w = next;
+	}
+	return resumed;
+}
+
+EthernetConnectWait::EthernetConnectWait(EthernetClient &client, IPAddress ip, uint16_t port)
+{
+	_client = &client;
+	_result = client.beginConnect(ip, port) ? -1 : 0;
+}
+
+bool EthernetConnectWait::ready()
+{
+	if (_result >= 0) return true;
+	_result = _client->pollConnect();
+	return _result >= 0;
+}
+
+bool EthernetReadWait::ready()
+{
+	if (_client->available() > 0) {
+		_result = _client->read(_buf, _size);
+	} else if (!_client->connected()) {
+		_result = 0;
+	} else if (expired(_timeout)) {
+		_result = -1;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool EthernetWriteWait::ready()
+{
+	// Only write what fits and never wait for the chip to send it
+	for (;;) {
+		if (_sending) {
+			int ret = _client->pollWrite();
+			if (ret < 0) return false;
+			_sending = false;
+			if (ret == 0) return true;
+		}
+		if (_result >= _size) return true;
+		size_t n = _client->beginWrite(_buf + _result, _size - _result);
+		if (n == 0) return !_client->connected() || expired(_timeout);
+		_result += n;
+		_sending = true;
+	}
+}
+
+bool EthernetAcceptWait::ready()
+{
+	EthernetClient client = _server->accept();
+	uint8_t stat = client.status();
+	if (stat == SnSR::ESTABLISHED || stat == SnSR::CLOSE_WAIT) {
+		_client = client;
+		return true;
+	}
+	return expired(_timeout);
+}
+
+bool EthernetPacketWait::ready()
+{
+	_result = _udp->parsePacket();
+	return _result > 0 || expired(_timeout);
+}
+
+EthernetResolveWait::EthernetResolveWait(DNSClient &dns, const char *host, uint16_t timeout)
+{
+	_dns = &dns;
+	_result = dns.beginQuery(host, timeout);
+	if (_result == 1) _result = 0; // waiting for pollQuery()
+}
+
+bool EthernetResolveWait::ready()
+{
+	if (_result == 0) _result = _dns->pollQuery(_ip);
+	return _result != 0;
+}
+
+EthernetConnectWait EthernetClient::connectAsync(IPAddress ip, uint16_t port)
+{
+	return EthernetConnectWait(*this, ip, port);
+}
+
+EthernetReadWait EthernetClient::readAsync(uint8_t *buf, size_t size, uint32_t timeout)
+{
+	return EthernetReadWait(*this, buf, size, timeout);
+}
+
+EthernetWriteWait EthernetClient::writeAsync(const uint8_t *buf, size_t size, uint32_t timeout)
+{
+	return EthernetWriteWait(*this, buf, size, timeout);
+}
+
+EthernetStopWait EthernetClient::stopAsync()
+{
+	return EthernetStopWait(*this);
+}
+
+EthernetAcceptWait EthernetServer::acceptAsync(uint32_t timeout)
+{
+	return EthernetAcceptWait(*this, *_eth, timeout);
+}
+
+EthernetPacketWait EthernetUDP::parsePacketAsync(uint32_t timeout)
+{
+	return EthernetPacketWait(*this, timeout);
+}
+
+EthernetResolveWait DNSClient::resolve(const char* aHostname, uint16_t timeout)
+{
+	return EthernetResolveWait(*this, aHostname, timeout);
+}
+
+#endif
@@ -25,6 +25,8 @@
 
 EthernetClient::EthernetClient(EthernetClass &ethernet){
 	_timeout = 1000;
+	_start = 0;
+	_useOptions = false;
 	_eth = & ethernet;
 	_sockindex = _eth->maxSocketNum();
 }
@@ -32,6 +34,8 @@ EthernetClient::EthernetClient(EthernetClass &ethernet){
 EthernetClient::EthernetClient(EthernetClass &ethernet, uint8_t s){
 	_sockindex = s;
 	_timeout = 1000;
+	_start = 0;
+	_useOptions = false;
 	_eth = & ethernet;
 }
  
@@ -52,6 +56,16 @@ int EthernetClient::connect(const char * host, uint16_t port)
 }
 
 int EthernetClient::connect(IPAddress ip, uint16_t port)
+{
+	if (!beginConnect(ip, port)) return 0;
+	int ret;
+	while ((ret = pollConnect()) < 0) {
+		delay(1);
+	}
+	return ret;
+}
+
+int EthernetClient::beginConnect(IPAddress ip, uint16_t port)
 {
 	if (_sockindex < _eth->maxSocketNum()) {
 		if (_eth->socketStatus(_sockindex) != SnSR::CLOSED) {
@@ -66,16 +80,20 @@ int EthernetClient::connect(IPAddress ip, uint16_t port)
 #endif
 	_sockindex = _eth->socketBegin(SnMR::TCP, 0);
 	if (_sockindex >= _eth->maxSocketNum()) return 0;
+	if (_useOptions) _eth->socketSetOptions(_sockindex, _options);
 	_eth->socketConnect(_sockindex, rawIPAddress(ip), port);
-	uint32_t start = millis();
-	while (1) {
-		uint8_t stat = _eth->socketStatus(_sockindex);
-		if (stat == SnSR::ESTABLISHED) return 1;
-		if (stat == SnSR::CLOSE_WAIT) return 1;
-		if (stat == SnSR::CLOSED) return 0;
-		if (millis() - start > _timeout) break;
-		delay(1);
-	}
+	_start = millis();
+	return 1;
+}
+
+int EthernetClient::pollConnect()
+{
+	if (_sockindex >= _eth->maxSocketNum()) return 0;
+	uint8_t stat = _eth->socketStatus(_sockindex);
+	if (stat == SnSR::ESTABLISHED) return 1;
+	if (stat == SnSR::CLOSE_WAIT) return 1;
+	if (stat == SnSR::CLOSED) return 0;
+	if (millis() - _start <= _timeout) return -1;
 	_eth->socketClose(_sockindex);
 	_sockindex = _eth->maxSocketNum();
 	return 0;
@@ -100,6 +118,19 @@ size_t EthernetClient::write(const uint8_t *buf, size_t size)
 	return 0;
 }
 
+size_t EthernetClient::beginWrite(const uint8_t *buf, size_t size)
+{
+	if (_sockindex >= _eth->maxSocketNum()) return 0;
+	if (size > _eth->SSIZE()) size = _eth->SSIZE();
+	return _eth->socketSendNoWait(_sockindex, buf, size);
+}
+
+int EthernetClient::pollWrite()
+{
+	if (_sockindex >= _eth->maxSocketNum()) return 0;
+	return _eth->socketSendStatus(_sockindex);
+}
+
 int EthernetClient::available()
 {
 	if (_sockindex >= _eth->maxSocketNum()) return 0;
@@ -142,25 +173,37 @@ void EthernetClient::flush()
 }
 
 void EthernetClient::stop()
+{
+	beginStop();
+	while (pollStop() < 0) {
+		delay(1);
+	}
+}
+
+void EthernetClient::beginStop()
 {
 	if (_sockindex >= _eth->maxSocketNum()) return;
 
 	// attempt to close the connection gracefully (send a FIN to other side)
 	_eth->socketDisconnect(_sockindex);
-	unsigned long start = millis();
+	_start = millis();
+}
 
-	// wait up to a second for the connection to close
-	do {
-		if (_eth->socketStatus(_sockindex) == SnSR::CLOSED) {
-			_sockindex = _eth->maxSocketNum();
-			return; // exit the loop
-		}
-		delay(1);
-	} while (millis() - start < _timeout);
+int EthernetClient::pollStop()
+{
+	if (_sockindex >= _eth->maxSocketNum()) return 1;
+
+	// wait up to the connection timeout for the connection to close
+	if (_eth->socketStatus(_sockindex) == SnSR::CLOSED) {
+		_sockindex = _eth->maxSocketNum();
+		return 1;
+	}
+	if (millis() - _start < _timeout) return -1;
 
 	// if it hasn't closed, close it forcefully
 	_eth->socketClose(_sockindex);
 	_sockindex = _eth->maxSocketNum();
+	return 0;
 }
 
 uint8_t EthernetClient::connected()
@@ -208,3 +251,38 @@ uint16_t EthernetClient::remotePort()
 {
 	return _eth->remotePort(_sockindex);
 }
+
+void EthernetClient::setRecvPolicy(EthernetRecvPolicy policy, uint16_t value)
+{
+	if (_sockindex >= _eth->maxSocketNum()) return;
+	_eth->socketSetRecvPolicy(_sockindex, policy, value);
+}
+
+void EthernetClient::setKeepAlive(uint16_t seconds)
+{
+	if (_sockindex >= _eth->maxSocketNum()) return;
+	_eth->socketSetKeepAlive(_sockindex, seconds);
+}
+
+// Also applied to an open connection, where the MSS no longer changes
+void EthernetClient::setSocketOptions(const EthernetSocketOptions &options)
+{
+	_options = options;
+	_useOptions = true;
+	if (_sockindex >= _eth->maxSocketNum()) return;
+	_eth->socketSetOptions(_sockindex, options);
+}
+
+void EthernetClient::setInterface(EthernetClass &ethernet)
+{
+	stop();
+	_eth = &ethernet;
+	_sockindex = _eth->maxSocketNum();
+}
+
+EthernetRecvStats EthernetClient::recvStats()
+{
+	EthernetRecvStats stats = {0, 0, 0};
+	if (_sockindex >= _eth->maxSocketNum()) return stats;
+	return _eth->socketRecvStats(_sockindex);
+}
@@ -0,0 +1,165 @@
+/* Copyright 2026 Lode Van Dyck
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+
+EthernetMulticast::EthernetMulticast(EthernetClass &ethernet) : EthernetUDP(ethernet){
+	_numGroups = 0;
+	_current = 0;
+	_link = Unknown;
+	_lastLinkCheck = 0;
+}
+
+// Open the socket of a group, the chip sends the join message on Sock_OPEN
+uint8_t EthernetMulticast::openGroup(group_t &group)
+{
+	uint8_t protocol = SnMR::UDP | SnMR::MULTI;
+	if (group.version == IGMPv1) protocol |= SnMR::MC;
+	group.sockindex = _eth->socketBeginMulticast(protocol, group.ip, group.port);
+	return group.sockindex < _eth->maxSocketNum();
+}
+
+uint8_t EthernetMulticast::join(IPAddress group, uint16_t port, EthernetIGMPVersion version)
+{
+	for (uint8_t i = 0; i < _numGroups; i++) {
+		if (_groups[i].ip == group && _groups[i].port == port) return 1;
+	}
+	if (_numGroups >= ETHERNET_MULTICAST_MAX_GROUPS) return 0;
+
+	group_t &g = _groups[_numGroups];
+	g.ip = group;
+	g.port = port;
+	g.version = version;
+	if (!openGroup(g)) return 0;
+	if (_numGroups == 0) {
+		_current = 0;
+		sockindex = g.sockindex;
+		_remaining = 0;
+	}
+	_numGroups++;
+	return 1;
+}
+
+void EthernetMulticast::leave(IPAddress group)
+{
+	uint8_t i = 0;
+	while (i < _numGroups) {
+		if (_groups[i].ip == group) {
+			if (_groups[i].sockindex == sockindex) {
+				sockindex = _eth->maxSocketNum();
+				_remaining = 0;
+			}
+			if (_groups[i].sockindex < _eth->maxSocketNum()) {
+				_eth->socketClose(_groups[i].sockindex);
+			}
+			for (uint8_t j = i + 1; j < _numGroups; j++) {
+				_groups[j - 1] = _groups[j];
+			}
+			_numGroups--;
+			if (_current > i) _current--;
+			if (_current >= _numGroups) _current = 0;
+		} else {
+			i++;
+		}
+	}
+}
+
+void EthernetMulticast::stop()
+{
+	for (uint8_t i = 0; i < _numGroups; i++) {
+		if (_groups[i].sockindex < _eth->maxSocketNum()) {
+			_eth->socketClose(_groups[i].sockindex);
+		}
+	}
+	_numGroups = 0;
+	_current = 0;
+	_remaining = 0;
+	sockindex = _eth->maxSocketNum();
+}
+
+uint8_t EthernetMulticast::rejoin()
+{
+	// Anything still waiting in the receive buffers is lost
+	_remaining = 0;
+	for (uint8_t i = 0; i < _numGroups; i++) {
+		if (_groups[i].sockindex < _eth->maxSocketNum()) {
+			_eth->socketClose(_groups[i].sockindex);
+			_groups[i].sockindex = _eth->maxSocketNum();
+		}
+	}
+	return openPending();
+}
+
+// Open the socket of every group that has none, because it could not be
+// opened when the group was joined again
+uint8_t EthernetMulticast::openPending()
+{
+	uint8_t opened = 0;
+	for (uint8_t i = 0; i < _numGroups; i++) {
+		if (_groups[i].sockindex >= _eth->maxSocketNum() && openGroup(_groups[i])) opened++;
+	}
+	sockindex = _numGroups ? _groups[_current].sockindex : _eth->maxSocketNum();
+	return opened;
+}
+
+int EthernetMulticast::maintain()
+{
+	if (millis() - _lastLinkCheck < ETHERNET_MULTICAST_LINK_INTERVAL) return 0;
+	_lastLinkCheck = millis();
+
+	// Switches and routers forget our memberships while the link is down,
+	// join again as soon as it is back.  (The W5100 can not report its link.)
+	EthernetLinkStatus link = _eth->linkStatus();
+	int rejoined = 0;
+	if (link == LinkON && _link == LinkOFF) {
+		rejoined = rejoin();
+	} else if (link != LinkOFF) {
+		// Groups without a socket stay pending and are tried again
+		rejoined = openPending();
+	}
+	_link = link;
+	return rejoined;
+}
+
+int EthernetMulticast::parsePacket()
+{
+	// Look at every group once, starting after the group of the last packet
+	for (uint8_t i = 0; i < _numGroups; i++) {
+		uint8_t g = (_current + 1 + i) % _numGroups;
+		if (_groups[g].sockindex >= _eth->maxSocketNum()) continue;
+
+		// discard any remaining bytes in the last packet
+		while (_remaining) {
+			read((uint8_t *)NULL, _remaining);
+		}
+		_current = g;
+		sockindex = _groups[g].sockindex;
+		int ret = EthernetUDP::parsePacket();
+		if (ret > 0) return ret;
+	}
+	return 0;
+}
+
+IPAddress EthernetMulticast::groupIP()
+{
+	if (_numGroups == 0) return IPAddress((uint32_t)0);
+	return _groups[_current].ip;
+}
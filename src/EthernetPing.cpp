@@ -0,0 +1,256 @@
+/* Copyright 2026 Lode Van Dyck
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+
+#define ICMP_ECHO_REPLY   0
+#define ICMP_ECHO_REQUEST 8
+#define ICMP_HEADER_SIZE  8
+#define PING_PAYLOAD_SIZE 8
+// In IPRAW mode every datagram in the receive buffer is preceded by a 6 byte
+// header: source IP (4) and length (2)
+#define IPRAW_HEADER_SIZE 6
+
+// Upper limits of the histogram buckets in microseconds
+static const uint32_t bucketLimits[ETHERNET_PING_BUCKETS - 1] = {
+	250, 500, 1000, 2000, 5000, 10000, 50000
+};
+
+EthernetPing::EthernetPing(EthernetClass &ethernet){
+	_eth = &ethernet;
+	sockindex = _eth->maxSocketNum();
+	_id = 0;
+	_seq = 0;
+	_timeout = 1000000;
+	_sending = false;
+	resetStats();
+}
+
+uint8_t EthernetPing::begin()
+{
+	stop();
+	sockindex = _eth->socketBeginIPRAW(IPPROTO::ICMP);
+	if (sockindex >= _eth->maxSocketNum()) return 0;
+	_id = micros();
+	return 1;
+}
+
+void EthernetPing::stop()
+{
+	if (sockindex < _eth->maxSocketNum()) {
+		_eth->socketClose(sockindex);
+		sockindex = _eth->maxSocketNum();
+	}
+	_sending = false;
+	for (uint8_t i = 0; i < ETHERNET_PING_MAX_INFLIGHT; i++) {
+		_inflight[i].target = ETHERNET_PING_MAX_TARGETS;
+	}
+}
+
+void EthernetPing::resetStats()
+{
+	_numTargets = 0;
+	for (uint8_t i = 0; i < ETHERNET_PING_MAX_TARGETS; i++) {
+		_stats[i] = EthernetPingStats();
+	}
+	for (uint8_t i = 0; i < ETHERNET_PING_MAX_INFLIGHT; i++) {
+		_inflight[i].target = ETHERNET_PING_MAX_TARGETS;
+	}
+}
+
+uint32_t EthernetPing::bucketLimit(uint8_t b)
+{
+	if (b >= ETHERNET_PING_BUCKETS - 1) return 0xFFFFFFFF;
+	return bucketLimits[b];
+}
+
+// The carries of the 16 bit one's complement sum are collected in the upper
+// half of a 32 bit accumulator and folded in once at the end.
+uint16_t EthernetPing::checksum(const uint8_t *data, uint16_t len)
+{
+	uint32_t sum = 0;
+
+	while (len > 1) {
+		sum += ((uint16_t)data[0] << 8) | data[1];
+		data += 2;
+		len -= 2;
+	}
+	if (len) sum += (uint16_t)data[0] << 8;
+	while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+	return ~sum;
+}
+
+uint8_t EthernetPing::inFlight()
+{
+	uint8_t n = 0;
+	for (uint8_t i = 0; i < ETHERNET_PING_MAX_INFLIGHT; i++) {
+		if (_inflight[i].target < ETHERNET_PING_MAX_TARGETS) n++;
+	}
+	return n;
+}
+
+EthernetPingStats* EthernetPing::stats(IPAddress target)
+{
+	for (uint8_t i = 0; i < _numTargets; i++) {
+		if (_stats[i].ip == target) return &_stats[i];
+	}
+	return NULL;
+}
+
+int EthernetPing::send(IPAddress target)
+{
+	if (sockindex >= _eth->maxSocketNum()) return 0;
+	// The destination can not change while the chip is sending
+	if (_sending) {
+		poll();
+		if (_sending) return 0;
+	}
+
+	uint8_t t, slot;
+	for (t = 0; t < _numTargets; t++) {
+		if (_stats[t].ip == target) break;
+	}
+	if (t == _numTargets) {
+		if (_numTargets >= ETHERNET_PING_MAX_TARGETS) return 0;
+		_stats[t].ip = target;
+		_stats[t].minRTT = 0xFFFFFFFF;
+		_numTargets++;
+	}
+	for (slot = 0; slot < ETHERNET_PING_MAX_INFLIGHT; slot++) {
+		if (_inflight[slot].target >= ETHERNET_PING_MAX_TARGETS) break;
+	}
+	if (slot == ETHERNET_PING_MAX_INFLIGHT) return 0;
+
+	uint8_t packet[ICMP_HEADER_SIZE + PING_PAYLOAD_SIZE];
+	uint32_t now = micros();
+	_seq++;
+	packet[0] = ICMP_ECHO_REQUEST;
+	packet[1] = 0;
+	packet[2] = 0; // checksum
+	packet[3] = 0;
+	packet[4] = _id >> 8;
+	packet[5] = _id & 0xFF;
+	packet[6] = _seq >> 8;
+	packet[7] = _seq & 0xFF;
+	// payload: send time and slot, handy when looking at a capture
+	packet[8] = now >> 24;
+	packet[9] = (now >> 16) & 0xFF;
+	packet[10] = (now >> 8) & 0xFF;
+	packet[11] = now & 0xFF;
+	packet[12] = slot;
+	packet[13] = 0;
+	packet[14] = 0;
+	packet[15] = 0;
+	uint16_t sum = checksum(packet, sizeof(packet));
+	packet[2] = sum >> 8;
+	packet[3] = sum & 0xFF;
+
+	if (!_eth->socketStartIPRAW(sockindex, target.raw_address())) return 0;
+	if (_eth->socketBufferData(sockindex, 0, packet, sizeof(packet)) != sizeof(packet)) return 0;
+	_eth->socketSendUDPNoWait(sockindex);
+
+	_inflight[slot].target = t;
+	_inflight[slot].seq = _seq;
+	_inflight[slot].sentMicros = now;
+	_stats[t].sent++;
+	_sending = true;
+	_sendingSlot = slot;
+	return 1;
+}
+
+void EthernetPing::reply(uint8_t slot, uint32_t rtt)
+{
+	EthernetPingStats &st = _stats[_inflight[slot].target];
+	_inflight[slot].target = ETHERNET_PING_MAX_TARGETS;
+
+	st.received++;
+	if (rtt < st.minRTT) st.minRTT = rtt;
+	if (rtt > st.maxRTT) st.maxRTT = rtt;
+	st.avgRTT += ((int32_t)(rtt - st.avgRTT)) / (int32_t)st.received;
+	if (st.received > 1) {
+		uint32_t d = rtt > st.lastRTT ? rtt - st.lastRTT : st.lastRTT - rtt;
+		st.jitter += ((int32_t)(d - st.jitter)) / 16;
+	}
+	st.lastRTT = rtt;
+
+	uint8_t b = 0;
+	while (b < ETHERNET_PING_BUCKETS - 1 && rtt >= bucketLimits[b]) b++;
+	if (st.histogram[b] < 0xFFFF) st.histogram[b]++;
+}
+
+void EthernetPing::lost(uint8_t slot)
+{
+	_stats[_inflight[slot].target].lost++;
+	_inflight[slot].target = ETHERNET_PING_MAX_TARGETS;
+}
+
+int EthernetPing::poll()
+{
+	if (sockindex >= _eth->maxSocketNum()) return 0;
+	uint32_t now = micros();
+	int replies = 0;
+
+	if (_sending) {
+		int ret = _eth->socketSendUDPStatus(sockindex);
+		if (ret >= 0) {
+			_sending = false;
+			// No ARP reply, the request never left
+			if (ret == 0 && _inflight[_sendingSlot].target < ETHERNET_PING_MAX_TARGETS) {
+				lost(_sendingSlot);
+			}
+		}
+	}
+
+	// Every ICMP message received by the chip ends up here,
+	// only the replies to our requests are used.
+	while (_eth->socketRecvAvailable(sockindex) > 0) {
+		uint8_t buf[IPRAW_HEADER_SIZE + ICMP_HEADER_SIZE + PING_PAYLOAD_SIZE];
+		uint16_t got = _eth->socketRecvPeek(sockindex, buf, sizeof(buf));
+		if (got < IPRAW_HEADER_SIZE) break;
+		uint16_t len = (buf[4] << 8) | buf[5];
+		_eth->socketRecvSkip(sockindex, IPRAW_HEADER_SIZE + len);
+
+		uint8_t *icmp = buf + IPRAW_HEADER_SIZE;
+		if (len != ICMP_HEADER_SIZE + PING_PAYLOAD_SIZE || got < IPRAW_HEADER_SIZE + len) continue;
+		if (icmp[0] != ICMP_ECHO_REPLY || icmp[1] != 0) continue;
+		if (((icmp[4] << 8) | icmp[5]) != _id) continue;
+		if (checksum(icmp, len) != 0) continue;
+
+		uint16_t seq = (icmp[6] << 8) | icmp[7];
+		IPAddress from(buf);
+		for (uint8_t i = 0; i < ETHERNET_PING_MAX_INFLIGHT; i++) {
+			if (_inflight[i].target < ETHERNET_PING_MAX_TARGETS && _inflight[i].seq == seq
+			  && _stats[_inflight[i].target].ip == from) {
+				reply(i, now - _inflight[i].sentMicros);
+				replies++;
+				break;
+			}
+		}
+	}
+
+	for (uint8_t i = 0; i < ETHERNET_PING_MAX_INFLIGHT; i++) {
+		if (_inflight[i].target < ETHERNET_PING_MAX_TARGETS &&
+		  now - _inflight[i].sentMicros > _timeout) {
+			lost(i);
+		}
+	}
+	return replies;
+}
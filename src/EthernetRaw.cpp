@@ -0,0 +1,98 @@
+/* Copyright 2026 Lode Van Dyck
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+
+// In MACRAW mode every frame in the receive buffer is preceded by a 2 byte
+// length, which includes the length bytes themselves.
+#define MACRAW_HEADER_SIZE 2
+
+EthernetRaw::EthernetRaw(EthernetClass &ethernet){
+	_eth = &ethernet;
+	sockindex = _eth->maxSocketNum();
+}
+
+uint8_t EthernetRaw::begin(bool macFilter)
+{
+	stop();
+	sockindex = _eth->socketBeginMACRAW(macFilter);
+	return sockindex < _eth->maxSocketNum();
+}
+
+void EthernetRaw::stop()
+{
+	if (sockindex < _eth->maxSocketNum()) {
+		_eth->socketClose(sockindex);
+		sockindex = _eth->maxSocketNum();
+	}
+}
+
+int EthernetRaw::readFrame(uint8_t *buffer, uint16_t size)
+{
+	if (sockindex >= _eth->maxSocketNum() || size == 0) return 0;
+
+	// Read the length first, so only the frame itself is transferred and
+	// not whatever follows it in the receive buffer
+	uint8_t header[MACRAW_HEADER_SIZE];
+	if (_eth->socketRecv(sockindex, header, MACRAW_HEADER_SIZE) < MACRAW_HEADER_SIZE) return 0;
+	uint16_t len = (header[0] << 8) | header[1];
+	if (len < MACRAW_HEADER_SIZE) {
+		// Should never happen, drop everything to get in sync again
+		_eth->socketRecvSkip(sockindex, _eth->socketRecvAvailable(sockindex));
+		return 0;
+	}
+	// A frame larger than the buffer is truncated, but removed completely
+	uint16_t copy = len - MACRAW_HEADER_SIZE;
+	if (copy > size) copy = size;
+	int got = copy ? _eth->socketRecv(sockindex, buffer, copy) : 0;
+	if (got < 0) got = 0;
+	_eth->socketRecvSkip(sockindex, len - MACRAW_HEADER_SIZE - got);
+	return got;
+}
+
+int EthernetRaw::readFrames(uint8_t *buffer, uint16_t size, EthernetFrameInfo *frames, uint8_t maxFrames)
+{
+	if (sockindex >= _eth->maxSocketNum()) return 0;
+
+	uint16_t got = _eth->socketRecvPeek(sockindex, buffer, size);
+	uint16_t used = 0;
+	uint8_t count = 0;
+	while (count < maxFrames && used + MACRAW_HEADER_SIZE <= got) {
+		uint16_t len = (buffer[used] << 8) | buffer[used + 1];
+		if (len < MACRAW_HEADER_SIZE || used + len > got) break;
+		frames[count].offset = used + MACRAW_HEADER_SIZE;
+		frames[count].length = len - MACRAW_HEADER_SIZE;
+		used += len;
+		count++;
+	}
+	_eth->socketRecvSkip(sockindex, used);
+	return count;
+}
+
+int EthernetRaw::writeFrame(const uint8_t *frame, uint16_t len)
+{
+	if (sockindex >= _eth->maxSocketNum()) return 0;
+	// A partial copy would advance TX_WR and be sent with the next frame
+	if (_eth->socketSendAvailable(sockindex) < len) return 0;
+	if (_eth->socketBufferData(sockindex, 0, frame, len) != len) return 0;
+	// Sending works the same as for a UDP datagram
+	return _eth->socketSendUDP(sockindex);
+}
@@ -0,0 +1,186 @@
+/* Copyright 2026 Lode Van Dyck
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+
+// IPAddress as a number, so prefixes can be masked
+static uint32_t ipToInt(IPAddress ip)
+{
+	return ((uint32_t)ip[0] << 24) | ((uint32_t)ip[1] << 16) | ((uint32_t)ip[2] << 8) | ip[3];
+}
+
+static uint32_t prefixMask(uint8_t length)
+{
+	if (length == 0) return 0;
+	if (length >= 32) return 0xFFFFFFFF;
+	return ~(0xFFFFFFFFul >> length);
+}
+
+EthernetRouter::EthernetRouter()
+{
+	_numRoutes = 0;
+	_numInterfaces = 0;
+	_lastLinkCheck = 0;
+	_timeout = 0;
+}
+
+int EthernetRouter::addInterface(EthernetClass &ethernet)
+{
+	for (uint8_t i = 0; i < _numInterfaces; i++) {
+		if (_interfaces[i].eth == &ethernet) return i;
+	}
+	if (_numInterfaces >= ETHERNET_ROUTER_MAX_INTERFACES) return -1;
+	_interfaces[_numInterfaces].eth = &ethernet;
+	_interfaces[_numInterfaces].up = true; // until maintain() finds otherwise
+	return _numInterfaces++;
+}
+
+int EthernetRouter::addRoute(IPAddress prefix, uint8_t length, EthernetClass &ethernet, uint8_t metric)
+{
+	if (_numRoutes >= ETHERNET_ROUTER_MAX_ROUTES) return 0;
+	int i = addInterface(ethernet);
+	if (i < 0) return 0;
+	if (length > 32) length = 32;
+	EthernetRoute &r = _routes[_numRoutes++];
+	r.prefix = prefix;
+	r.length = length;
+	r.metric = metric;
+	r.interface = i;
+	r.subnet = false;
+	return 1;
+}
+
+int EthernetRouter::addSubnetRoute(EthernetClass &ethernet, uint8_t metric)
+{
+	if (!addRoute(IPAddress(0, 0, 0, 0), 0, ethernet, metric)) return 0;
+	_routes[_numRoutes - 1].subnet = true;
+	return 1;
+}
+
+void EthernetRouter::removeRoutes(EthernetClass &ethernet)
+{
+	for (uint8_t i = 0; i < _numRoutes; ) {
+		if (_interfaces[_routes[i].interface].eth == &ethernet) {
+			_routes[i] = _routes[--_numRoutes];
+		} else {
+			i++;
+		}
+	}
+}
+
+void EthernetRouter::clear()
+{
+	_numRoutes = 0;
+	_numInterfaces = 0;
+}
+
+// Index of the interface of the best route to ip, leaving out the
+// interfaces in the skip bit mask.  -1 if there is none.
+int EthernetRouter::select(IPAddress ip, uint8_t skip)
+{
+	uint32_t addr = ipToInt(ip);
+	int best = -1;
+	uint8_t bestLength = 0;
+	uint8_t bestMetric = 0;
+
+	for (uint8_t i = 0; i < _numRoutes; i++) {
+		const EthernetRoute &r = _routes[i];
+		const interface_t &itf = _interfaces[r.interface];
+		if (!itf.up || (skip & (1 << r.interface))) continue;
+
+		uint32_t prefix, mask;
+		uint8_t length = r.length;
+		if (r.subnet) {
+			mask = ipToInt(itf.eth->subnetMask());
+			prefix = ipToInt(itf.eth->localIP());
+			if (prefix == 0) continue; // no address yet
+			length = 0;
+			for (uint32_t m = mask; m & 0x80000000ul; m <<= 1) length++;
+		} else {
+			mask = prefixMask(length);
+			prefix = ipToInt(r.prefix);
+		}
+		if ((addr & mask) != (prefix & mask)) continue;
+
+		if (best < 0 || length > bestLength || (length == bestLength && r.metric < bestMetric)) {
+			best = r.interface;
+			bestLength = length;
+			bestMetric = r.metric;
+		}
+	}
+	return best;
+}
+
+EthernetClass* EthernetRouter::route(IPAddress ip)
+{
+	int i = select(ip, 0);
+	return i < 0 ? NULL : _interfaces[i].eth;
+}
+
+int EthernetRouter::connect(EthernetClient &client, IPAddress ip, uint16_t port)
+{
+	uint8_t tried = 0;
+	uint16_t timeout = client._timeout;
+	int ret = 0;
+	int i;
+
+	client.stop();
+	// The router's timeout only applies to these attempts, the client
+	// gets its own back for later connects and stop()
+	if (_timeout) client.setConnectionTimeout(_timeout);
+	while ((i = select(ip, tried)) >= 0) {
+		tried |= 1 << i;
+		client.setInterface(*_interfaces[i].eth);
+		if (client.connect(ip, port)) {
+			ret = 1;
+			break;
+		}
+	}
+	client.setConnectionTimeout(timeout);
+	return ret;
+}
+
+int EthernetRouter::maintain()
+{
+	if (millis() - _lastLinkCheck < ETHERNET_ROUTER_LINK_INTERVAL) return 0;
+	_lastLinkCheck = millis();
+
+	// A W5100 can't tell the link status, it counts as up
+	int changed = 0;
+	for (uint8_t i = 0; i < _numInterfaces; i++) {
+		EthernetClass *eth = _interfaces[i].eth;
+		bool up = eth->hardwareInitialized() && eth->linkStatus() != LinkOFF;
+		if (up != _interfaces[i].up) {
+			_interfaces[i].up = up;
+			changed++;
+		}
+	}
+	return changed;
+}
+
+bool EthernetRouter::linkUp(EthernetClass &ethernet)
+{
+	for (uint8_t i = 0; i < _numInterfaces; i++) {
+		if (_interfaces[i].eth == &ethernet) return _interfaces[i].up;
+	}
+	return false;
+}
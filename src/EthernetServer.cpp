@@ -26,12 +26,14 @@ EthernetServer::EthernetServer(EthernetClass &ethernet, uint16_t port){
 	_port = port;
 	_eth = &ethernet;
 	_sockindex = _eth->maxSocketNum();
+	_useOptions = false;
 }
 
 void EthernetServer::begin()
 {
 	_sockindex = _eth->socketBegin(SnMR::TCP, _port);
 	if (_sockindex < _eth->maxSocketNum()) {
+		if (_useOptions) _eth->socketSetOptions(_sockindex, _options);
 		if (_eth->socketListen(_sockindex)) {
 		} else {
 			_eth->socketDisconnect(_sockindex);
@@ -94,6 +96,12 @@ EthernetClient EthernetServer::accept()
 	return EthernetClient(*this->_eth, sockindex2);
 }
 
+void EthernetServer::setSocketOptions(const EthernetSocketOptions &options)
+{
+	_options = options;
+	_useOptions = true;
+}
+
 EthernetServer::operator bool()
 {
 	if(_sockindex < _eth->maxSocketNum()){
@@ -0,0 +1,289 @@
+/* Copyright 2026 Lode Van Dyck
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+
+#define CLOSE_TIMEOUT 1000 // ms before a Close gives up on a graceful disconnect
+#define STATE_DONE 0xFF    // waiting for room in the completion queue
+
+EthernetTask::EthernetTask(EthernetClass &ethernet)
+{
+	_eth = &ethernet;
+	_order = 0;
+	_connectTimeout = 10000;
+	for (uint8_t i = 0; i < ETHERNET_TASK_CLIENTS; i++) {
+		_clients[i] = NULL;
+	}
+	for (uint8_t i = 0; i < ETHERNET_TASK_PENDING; i++) {
+		_pending[i].used = false;
+	}
+}
+
+int EthernetTask::attach(EthernetCompletionQueue &queue)
+{
+	for (uint8_t i = 0; i < ETHERNET_TASK_CLIENTS; i++) {
+		if (_clients[i] == NULL || _clients[i] == &queue) {
+			_clients[i] = &queue;
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool EthernetTask::submit(const EthernetRequest &request)
+{
+	return _requests.push(request);
+}
+
+bool EthernetTask::connect(uint8_t client, IPAddress ip, uint16_t port, uint32_t tag)
+{
+	EthernetRequest r;
+	memset(&r, 0, sizeof(r));
+	r.op = NetConnect;
+	r.client = client;
+	for (uint8_t i = 0; i < 4; i++) r.ip[i] = ip[i];
+	r.port = port;
+	r.tag = tag;
+	return submit(r);
+}
+
+bool EthernetTask::listen(uint8_t client, uint16_t port, uint32_t tag)
+{
+	EthernetRequest r;
+	memset(&r, 0, sizeof(r));
+	r.op = NetListen;
+	r.client = client;
+	r.port = port;
+	r.tag = tag;
+	return submit(r);
+}
+
+bool EthernetTask::accept(uint8_t client, uint8_t s, uint32_t timeout, uint32_t tag)
+{
+	EthernetRequest r;
+	memset(&r, 0, sizeof(r));
+	r.op = NetAccept;
+	r.client = client;
+	r.socket = s;
+	r.timeout = timeout;
+	r.tag = tag;
+	return submit(r);
+}
+
+bool EthernetTask::send(uint8_t client, uint8_t s, const uint8_t *data, uint16_t len, uint32_t timeout, uint32_t tag)
+{
+	EthernetRequest r;
+	memset(&r, 0, sizeof(r));
+	r.op = NetSend;
+	r.client = client;
+	r.socket = s;
+	r.data = (uint8_t *)data;
+	r.len = len;
+	r.timeout = timeout;
+	r.tag = tag;
+	return submit(r);
+}
+
+bool EthernetTask::recv(uint8_t client, uint8_t s, uint8_t *data, uint16_t len, uint32_t timeout, uint32_t tag)
+{
+	EthernetRequest r;
+	memset(&r, 0, sizeof(r));
+	r.op = NetRecv;
+	r.client = client;
+	r.socket = s;
+	r.data = data;
+	r.len = len;
+	r.timeout = timeout;
+	r.tag = tag;
+	return submit(r);
+}
+
+bool EthernetTask::close(uint8_t client, uint8_t s, uint32_t tag)
+{
+	EthernetRequest r;
+	memset(&r, 0, sizeof(r));
+	r.op = NetClose;
+	r.client = client;
+	r.socket = s;
+	r.tag = tag;
+	return submit(r);
+}
+
+// True if an older request on the same socket is still in progress
+bool EthernetTask::waiting(const pending_t &p)
+{
+	if (p.req.op == NetConnect || p.req.op == NetListen) return false;
+	for (uint8_t i = 0; i < ETHERNET_TASK_PENDING; i++) {
+		const pending_t &q = _pending[i];
+		if (!q.used || &q == &p || q.req.socket != p.req.socket) continue;
+		if (q.state == STATE_DONE) continue;
+		// A Connect has no socket until it has started
+		if (q.req.op == NetConnect && q.state == 0) continue;
+		if ((int32_t)(q.order - p.order) < 0) return true;
+	}
+	return false;
+}
+
+// Work on one request without waiting, true when it is done
+bool EthernetTask::step(pending_t &p)
+{
+	EthernetRequest &r = p.req;
+	uint8_t max = _eth->maxSocketNum();
+	uint32_t elapsed = millis() - p.start;
+	bool expired = r.timeout && elapsed >= r.timeout;
+	uint8_t status;
+
+	if (r.op != NetConnect && r.op != NetListen && r.socket >= max) {
+		r.result = 0;
+		return true;
+	}
+
+	switch (r.op) {
+	case NetConnect:
+		if (p.state == 0) {
+			r.socket = _eth->socketBegin(SnMR::TCP, 0);
+			if (r.socket >= max) return true;
+			_eth->socketConnect(r.socket, r.ip, r.port);
+			p.state = 1;
+			return false;
+		}
+		status = _eth->socketStatus(r.socket);
+		if (status == SnSR::ESTABLISHED || status == SnSR::CLOSE_WAIT) {
+			r.result = 1;
+			return true;
+		}
+		if (status != SnSR::CLOSED && elapsed < (r.timeout ? r.timeout : _connectTimeout)) return false;
+		_eth->socketClose(r.socket);
+		r.socket = max;
+		return true;
+
+	case NetListen:
+		r.socket = _eth->socketBegin(SnMR::TCP, r.port);
+		if (r.socket >= max) return true;
+		if (!_eth->socketListen(r.socket)) {
+			_eth->socketClose(r.socket);
+			r.socket = max;
+			return true;
+		}
+		r.result = 1;
+		return true;
+
+	case NetAccept:
+		status = _eth->socketStatus(r.socket);
+		if (status == SnSR::ESTABLISHED || status == SnSR::CLOSE_WAIT) {
+			r.result = 1;
+		} else if (status == SnSR::CLOSED) {
+			r.result = 0;
+		} else if (expired) {
+			r.result = -1;
+		} else {
+			return false;
+		}
+		return true;
+
+	case NetSend:
+		// result counts the bytes sent.  State 0 copies what fits and
+		// starts sending it, state 1 waits for the chip to finish, so
+		// neither ever waits for the chip while holding the bus.
+		if (p.state == 1) {
+			int ret = _eth->socketSendStatus(r.socket);
+			if (ret < 0) return false;
+			if (ret == 0) return true;
+			p.state = 0;
+			if (r.result >= r.len) return true;
+		}
+		if (r.result < r.len) {
+			uint16_t n = _eth->socketSendNoWait(r.socket, r.data + r.result, r.len - r.result);
+			if (n > 0) {
+				r.result += n;
+				p.state = 1;
+				return false;
+			}
+		}
+		status = _eth->socketStatus(r.socket);
+		if (status != SnSR::ESTABLISHED && status != SnSR::CLOSE_WAIT) return true;
+		return r.result >= r.len || expired;
+
+	case NetRecv: {
+		int n = _eth->socketRecv(r.socket, r.data, r.len);
+		if (n >= 0) {
+			r.result = n;
+		} else if (expired) {
+			r.result = -1;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	case NetClose:
+		if (p.state == 0) {
+			_eth->socketDisconnect(r.socket);
+			p.state = 1;
+		}
+		if (_eth->socketStatus(r.socket) != SnSR::CLOSED) {
+			if (elapsed < CLOSE_TIMEOUT) return false;
+			_eth->socketClose(r.socket);
+		}
+		r.result = 1;
+		return true;
+	}
+	return true;
+}
+
+int EthernetTask::poll()
+{
+	int done = 0;
+	EthernetTransaction t(*_eth);
+
+	// Take new requests while there is room for them
+	for (uint8_t i = 0; i < ETHERNET_TASK_PENDING; i++) {
+		pending_t &p = _pending[i];
+		if (p.used) continue;
+		if (!_requests.pop(p.req)) break;
+		p.req.result = 0;
+		p.state = 0;
+		p.order = _order++;
+		p.start = millis();
+		p.used = true;
+	}
+
+	for (uint8_t i = 0; i < ETHERNET_TASK_PENDING; i++) {
+		pending_t &p = _pending[i];
+		if (!p.used) continue;
+		if (p.state != STATE_DONE) {
+			if (waiting(p)) {
+				// The timeout starts once the older requests are done
+				p.start = millis();
+				continue;
+			}
+			if (!step(p)) continue;
+			p.state = STATE_DONE;
+		}
+		EthernetRequest &r = p.req;
+		EthernetCompletionQueue *queue = r.client < ETHERNET_TASK_CLIENTS ? _clients[r.client] : NULL;
+		if (queue && !queue->push(r)) continue; // try again in the next poll()
+		p.used = false;
+		done++;
+	}
+	return done;
+}
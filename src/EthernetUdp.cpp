@@ -35,6 +35,18 @@
 EthernetUDP::EthernetUDP(EthernetClass &ethernet){
 	_eth = &ethernet;
 	sockindex = _eth->maxSocketNum();
+	_asyncSend = false;
+	_sendStatus = 1;
+	_sendTimeouts = 0;
+	_sendMAC = false;
+	_learnMAC = false;
+	_pinnedValid = false;
+	_pinnedLearned = false;
+	_txBuffer = NULL;
+	_txSize = 0;
+	_txLen = 0;
+	_txData = NULL;
+	_txTruncated = false;
 }
 
 /* Start EthernetUDP socket, listening at local port PORT */
@@ -45,6 +57,8 @@ uint8_t EthernetUDP::begin(uint16_t port)
 	if (sockindex >= _eth->maxSocketNum()) return 0;
 	_port = port;
 	_remaining = 0;
+	_sendStatus = 1;
+	_sendTimeouts = 0;
 	return 1;
 }
 
@@ -62,6 +76,7 @@ void EthernetUDP::stop()
 		_eth->socketClose(sockindex);
 		sockindex = _eth->maxSocketNum();
 	}
+	_sendStatus = 1;
 }
 
 int EthernetUDP::beginPacket(const char *host, uint16_t port)
@@ -79,14 +94,141 @@ int EthernetUDP::beginPacket(const char *host, uint16_t port)
 
 int EthernetUDP::beginPacket(IPAddress ip, uint16_t port)
 {
+	// The previous packet may still be on its way.  The destination is
+	// only staged here and written to the socket by endPacket(), so this
+	// packet can be collected in the packet buffer while the previous one
+	// is sent.
+	if (uint32_t(ip) == 0 || port == 0) return 0;
 	_offset = 0;
+	_txLen = 0;
+	_txData = NULL;
+	_txTruncated = false;
+	_sendIP = ip;
+	_sendPort = port;
 	//Serial.printf("UDP beginPacket\n");
-	return _eth->socketStartUDP(sockindex, rawIPAddress(ip), port);
+	return 1;
+}
+
+int EthernetUDP::beginPacket(IPAddress ip, uint16_t port, const uint8_t *data, uint16_t len)
+{
+	if (!beginPacket(ip, port)) return 0;
+	_txData = data;
+	_txDataLen = len;
+	return 1;
+}
+
+void EthernetUDP::setPacketBuffer(uint8_t *buffer, uint16_t size)
+{
+	if (size > _eth->SSIZE()) size = _eth->SSIZE();
+	_txBuffer = buffer;
+	_txSize = buffer ? size : 0;
+	_txLen = 0;
+}
+
+// Copy data to the chip, remembering if it did not all fit
+void EthernetUDP::bufferData(const uint8_t *buffer, uint16_t size)
+{
+	// Copying moves TX_WR, and none of the chips documents what a SEND in
+	// progress does when TX_WR moves under it, so wait for it to finish
+	while (pollSend() < 0) {
+		yield();
+	}
+	uint16_t bytes_written = _eth->socketBufferData(sockindex, _offset, buffer, size);
+	if (bytes_written < size) _txTruncated = true;
+	_offset += bytes_written;
+}
+
+// Copy the collected packet data to the chip
+void EthernetUDP::flushPacketBuffer()
+{
+	if (_txLen > 0) {
+		bufferData(_txBuffer, _txLen);
+		_txLen = 0;
+	}
 }
 
 int EthernetUDP::endPacket()
 {
-	return _eth->socketSendUDP(sockindex);
+	if (_txData) {
+		bufferData(_txData, _txDataLen);
+		_txData = NULL;
+	}
+	flushPacketBuffer();
+
+	// The destination of the socket can only be changed once the
+	// previous packet has been sent, also when no data was copied
+	while (pollSend() < 0) {
+		yield();
+	}
+	if (!_eth->socketStartUDP(sockindex, rawIPAddress(_sendIP), _sendPort)) return 0;
+	_sendMAC = false;
+	// The chip never reports a failure for Sock_SEND_MAC, so a learned
+	// address is dropped after a while and resolved with ARP again
+	if (_pinnedValid && _pinnedLearned && millis() - _pinnedTime >= ETHERNET_UDP_MAC_AGE) {
+		_pinnedValid = false;
+	}
+	if (_pinnedValid && _pinnedIP == _sendIP) {
+		_eth->socketSetRemoteMAC(sockindex, _pinnedMAC);
+		_sendMAC = true;
+	}
+	SockCMD cmd = _sendMAC ? Sock_SEND_MAC : Sock_SEND;
+	// _sendIP may already be the next packet's by the time the outcome
+	// of this one is collected
+	_inflightIP = _sendIP;
+
+	// A truncated packet is still sent, so its data does not end up in
+	// front of the next one, but it is reported as failed
+	if (_asyncSend) {
+		_eth->socketSendUDPNoWait(sockindex, cmd);
+		_sendStatus = -1;
+		return _txTruncated ? 0 : 1;
+	}
+	int ret = _eth->socketSendUDP(sockindex, cmd);
+	sendDone(ret);
+	return _txTruncated ? 0 : ret;
+}
+
+int EthernetUDP::pollSend()
+{
+	if (_sendStatus < 0) {
+		int ret = _eth->socketSendUDPStatus(sockindex);
+		if (ret < 0) return -1;
+		sendDone(ret);
+		_sendStatus = ret;
+	}
+	return _sendStatus;
+}
+
+// Book keeping after the chip reported the outcome of a packet
+void EthernetUDP::sendDone(int ok)
+{
+	if (!ok) {
+		_sendTimeouts++;
+	} else if (_learnMAC && !_sendMAC && !_pinnedValid) {
+		// Broadcast and multicast destinations are not resolved with ARP
+		if (_inflightIP[0] >= 224) return;
+		if ((uint32_t(_inflightIP) | ~uint32_t(_eth->subnetMask())) == 0xFFFFFFFF) return;
+		_eth->socketRemoteMAC(sockindex, _pinnedMAC);
+		_pinnedIP = _inflightIP;
+		_pinnedValid = true;
+		_pinnedLearned = true;
+		_pinnedTime = millis();
+	}
+}
+
+void EthernetUDP::setRemoteMAC(IPAddress ip, const uint8_t *mac)
+{
+	memcpy(_pinnedMAC, mac, 6);
+	_pinnedIP = ip;
+	_pinnedValid = true;
+	_pinnedLearned = false;
+}
+
+bool EthernetUDP::remoteMAC(IPAddress ip, uint8_t *mac)
+{
+	if (!_pinnedValid || !(_pinnedIP == ip)) return false;
+	memcpy(mac, _pinnedMAC, 6);
+	return true;
 }
 
 size_t EthernetUDP::write(uint8_t byte)
@@ -97,9 +239,20 @@ size_t EthernetUDP::write(uint8_t byte)
 size_t EthernetUDP::write(const uint8_t *buffer, size_t size)
 {
 	//Serial.printf("UDP write %d\n", size);
-	uint16_t bytes_written = _eth->socketBufferData(sockindex, _offset, buffer, size);
-	_offset += bytes_written;
-	return bytes_written;
+	// The packet data was already given to beginPacket()
+	if (_txData) return 0;
+	if (_txBuffer) {
+		if (_txLen + size > _txSize) flushPacketBuffer();
+		if (size <= _txSize) {
+			memcpy(_txBuffer + _txLen, buffer, size);
+			_txLen += size;
+			return size;
+		}
+		// Too big for the buffer, write it to the chip directly
+	}
+	uint16_t start = _offset;
+	bufferData(buffer, size);
+	return _offset - start;
 }
 
 int EthernetUDP::parsePacket()
@@ -134,6 +287,18 @@ int EthernetUDP::parsePacket()
 	return 0;
 }
 
+int EthernetUDP::parsePackets(uint8_t *buffer, size_t size, EthernetUDPPacketInfo *packets, uint8_t maxPackets)
+{
+	// discard any remaining bytes in the last packet
+	while (_remaining) {
+		read((uint8_t *)NULL, _remaining);
+	}
+
+	if (sockindex >= _eth->maxSocketNum()) return 0;
+	if (size > 0xFFFF) size = 0xFFFF;
+	return _eth->socketRecvUDPBatch(sockindex, buffer, size, packets, maxPackets);
+}
+
 int EthernetUDP::read()
 {
 	uint8_t byte;
@@ -192,5 +357,7 @@ uint8_t EthernetUDP::beginMulticast(IPAddress ip, uint16_t port)
 	if (sockindex >= _eth->maxSocketNum()) return 0;
 	_port = port;
 	_remaining = 0;
+	_sendStatus = 1;
+	_sendTimeouts = 0;
 	return 1;
 }
@@ -28,6 +28,31 @@ extern void yield(void);
 #define yield()
 #endif
 
+#if ETHERNET_LOCKING
+// Holds the lock of socket s until the end of the function, see setLocking()
+class SocketGuard {
+public:
+	SocketGuard(EthernetLocking *locking, uint8_t s) : _locking(locking), _s(s) {
+		if (_locking) _locking->lockSocket(_s);
+	}
+	~SocketGuard() {
+		if (_locking) _locking->unlockSocket(_s);
+	}
+private:
+	EthernetLocking *_locking;
+	uint8_t _s;
+};
+#define SOCKET_LOCK(s) SocketGuard socketGuard(_locking, s)
+#else
+#define SOCKET_LOCK(s)
+#endif
+
+#if ETHERNET_SOCKET_STATS
+#define SOCKET_STAT(s, field, n) (socketState[s].stats.field += (n))
+#else
+#define SOCKET_STAT(s, field, n) ((void)0)
+#endif
+
 /*****************************************/
 /*          Socket management            */
 /*****************************************/
@@ -90,10 +115,7 @@ makesocket:
 		_w5x00->writeSnPORT(s, local_port);
 	}
 	_w5x00->execCmdSn(s, Sock_OPEN);
-	socketState[s].RX_RSR = 0;
-	socketState[s].RX_RD  = _w5x00->readSnRX_RD(s); // always zero?
-	socketState[s].RX_inc = 0;
-	socketState[s].TX_FSR = 0;
+	resetState(s);
 	//Serial.printf("W5000socket prot=%d, RX_RD=%d\n", _w5x00->readSnMR(s), socketState[s].RX_RD);
 	_w5x00->endTransaction();
 	return s;
@@ -158,21 +180,71 @@ makesocket:
     	_w5x00->writeSnDPORT(s, port);
     	_w5x00->writeSnDHAR(s, mac);
 	_w5x00->execCmdSn(s, Sock_OPEN);
-	socketState[s].RX_RSR = 0;
-	socketState[s].RX_RD  = _w5x00->readSnRX_RD(s); // always zero?
-	socketState[s].RX_inc = 0;
-	socketState[s].TX_FSR = 0;
+	resetState(s);
 	//Serial.printf("W5000socket prot=%d, RX_RD=%d\n", _w5x00->readSnMR(s), socketState[s].RX_RD);
 	_w5x00->endTransaction();
 	return s;
 }
+uint8_t EthernetClass::socketBeginMACRAW(bool macFilter)
+{
+	uint8_t protocol = SnMR::MACRAW;
+	if (macFilter) {
+		// The bit differs between the chips, the W5100 has no filter
+		uint8_t filter = _w5x00->macFilterMode();
+		if (!filter) return _w5x00->maxSockNum();
+		protocol |= filter;
+	}
+	_w5x00->beginTransaction();
+	if (_w5x00->readSnSR(0) != SnSR::CLOSED) {
+		_w5x00->endTransaction();
+		return _w5x00->maxSockNum(); // socket 0 is in use
+	}
+	_w5x00->writeSnMR(0, protocol);
+	_w5x00->writeSnIR(0, 0xFF);
+	_w5x00->execCmdSn(0, Sock_OPEN);
+	resetState(0);
+	_w5x00->endTransaction();
+	return 0;
+}
+
+uint8_t EthernetClass::socketBeginIPRAW(uint8_t ipProtocol)
+{
+	uint8_t s = socketBegin(SnMR::IPRAW, 0);
+	if (s >= _w5x00->maxSockNum()) return s;
+
+	// The protocol is only taken into account when the socket is opened
+	_w5x00->beginTransaction();
+	_w5x00->execCmdSn(s, Sock_CLOSE);
+	_w5x00->writeSnPROTO(s, ipProtocol);
+	_w5x00->writeSnMR(s, SnMR::IPRAW);
+	_w5x00->execCmdSn(s, Sock_OPEN);
+	resetState(s);
+	_w5x00->endTransaction();
+	return s;
+}
+
 // Return the socket's status
 // TODO: instead of uint8_t this can return an SnSR object
 uint8_t EthernetClass::socketStatus(uint8_t s)
 {
+	SOCKET_LOCK(s);
 	_w5x00->beginTransaction();
 	uint8_t status = _w5x00->readSnSR(s);
 	_w5x00->endTransaction();
+#if ETHERNET_SOCKET_STATS
+	socketstate_t &st = socketState[s];
+	if (st.connectStart && status == SnSR::ESTABLISHED) {
+		st.stats.connectTime = micros() - st.connectStart;
+		st.connectStart = 0;
+	}
+	if (status == SnSR::CLOSED) {
+		st.connectStart = 0; // connect failed
+		if (st.closeStart) {
+			st.stats.closeTime = micros() - st.closeStart;
+			st.closeStart = 0;
+		}
+	}
+#endif
 	return status;
 }
 
@@ -181,6 +253,7 @@ uint8_t EthernetClass::socketStatus(uint8_t s)
 //
 void EthernetClass::socketClose(uint8_t s)
 {
+	SOCKET_LOCK(s);
 	_w5x00->beginTransaction();
 	_w5x00->execCmdSn(s, Sock_CLOSE);
 	_w5x00->endTransaction();
@@ -190,6 +263,7 @@ void EthernetClass::socketClose(uint8_t s)
 //
 uint8_t EthernetClass::socketListen(uint8_t s)
 {
+	SOCKET_LOCK(s);
 	_w5x00->beginTransaction();
 	if (_w5x00->readSnSR(s) != SnSR::INIT) {
 		_w5x00->endTransaction();
@@ -204,21 +278,29 @@ uint8_t EthernetClass::socketListen(uint8_t s)
 //
 void EthernetClass::socketConnect(uint8_t s, uint8_t * addr, uint16_t port)
 {
+	SOCKET_LOCK(s);
 	// set destination IP
 	_w5x00->beginTransaction();
 	_w5x00->writeSnDIPR(s, addr);
 	_w5x00->writeSnDPORT(s, port);
 	_w5x00->execCmdSn(s, Sock_CONNECT);
 	_w5x00->endTransaction();
+#if ETHERNET_SOCKET_STATS
+	socketState[s].connectStart = micros() | 1;
+#endif
 }
 
 // Gracefully disconnect a TCP connection.
 //
 void EthernetClass::socketDisconnect(uint8_t s)
 {
+	SOCKET_LOCK(s);
 	_w5x00->beginTransaction();
 	_w5x00->execCmdSn(s, Sock_DISCON);
 	_w5x00->endTransaction();
+#if ETHERNET_SOCKET_STATS
+	socketState[s].closeStart = micros() | 1;
+#endif
 }
 
 /*****************************************/
@@ -261,13 +343,16 @@ void EthernetClass::read_data(uint8_t s, uint16_t src, uint8_t *dst, uint16_t le
 		_w5x00->read(src_ptr, dst, size);
 		dst += size;
 		_w5x00->read(_w5x00->RBASE(s), dst, len - size);
+		_w5x00->sockSpiStat(s, 0);
 	}
+	_w5x00->sockSpiStat(s, len);
 }
 
 // Receive data.  Returns size, or -1 for no data, or 0 if connection closed
 //
 int EthernetClass::socketRecv(uint8_t s, uint8_t *buf, int16_t len)
 {
+	SOCKET_LOCK(s);
 	// Check how much data is available
 	int ret = socketState[s].RX_RSR;
 	_w5x00->beginTransaction();
@@ -291,29 +376,256 @@ int EthernetClass::socketRecv(uint8_t s, uint8_t *buf, int16_t len)
 		}
 	} else {
 		if (ret > len) ret = len; // more data available than buffer length
-		uint16_t ptr = socketState[s].RX_RD;
-		if (buf) read_data(s, ptr, buf, ret);
-		ptr += ret;
-		socketState[s].RX_RD = ptr;
-		socketState[s].RX_RSR -= ret;
-		uint16_t inc = socketState[s].RX_inc + ret;
-		if (inc >= 250 || socketState[s].RX_RSR == 0) {
-			socketState[s].RX_inc = 0;
-			_w5x00->writeSnRX_RD(s, ptr);
-			_w5x00->execCmdSn(s, Sock_RECV);
-			//Serial.printf("Sock_RECV cmd, RX_RD=%d, RX_RSR=%d\n",
-			//  socketState[s].RX_RD, socketState[s].RX_RSR);
-		} else {
-			socketState[s].RX_inc = inc;
-		}
+		if (buf) read_data(s, socketState[s].RX_RD, buf, ret);
+		recvAdvance(s, ret);
 	}
 	_w5x00->endTransaction();
 	//Serial.printf("socketRecv, ret=%d\n", ret);
 	return ret;
 }
 
+// Remove len bytes that were read from the receive buffer.  RX_RD is only
+// written to the chip once enough data was read (see setRecvPolicy), to
+// save SPI transfers.
+//
+void EthernetClass::recvAdvance(uint8_t s, uint16_t len)
+{
+	socketstate_t &st = socketState[s];
+	st.RX_RD += len;
+	st.RX_RSR -= len;
+	st.RX_inc += len;
+	st.RX_reads++;
+	SOCKET_STAT(s, rxBytes, len);
+	st.RX_avg = st.RX_avg - (st.RX_avg >> 3) + (len >> 3);
+	if (st.RX_inc >= recvWindow(s) || st.RX_RSR == 0) {
+		recvCommit(s);
+		//Serial.printf("Sock_RECV cmd, RX_RD=%d, RX_RSR=%d\n",
+		//  socketState[s].RX_RD, socketState[s].RX_RSR);
+	}
+}
+
+// Give all data read so far back to the chip
+void EthernetClass::recvCommit(uint8_t s)
+{
+	socketState[s].RX_inc = 0;
+	socketState[s].RX_commits++;
+	SOCKET_STAT(s, recvCmds, 1);
+	socketState[s].KA_last = millis();
+	_w5x00->writeSnRX_RD(s, socketState[s].RX_RD);
+	_w5x00->execCmdSn(s, Sock_RECV);
+}
+
+// Number of read bytes after which they are given back to the chip
+uint16_t EthernetClass::recvWindow(uint8_t s)
+{
+	uint16_t size = _w5x00->SSIZE;
+	uint16_t window;
+
+	switch (socketState[s].RX_policy) {
+	case RecvFraction:
+		return (uint32_t)size * socketState[s].RX_value / 100;
+	case RecvAdaptive:
+		// Small reads are collected up to 1/8 of the buffer, large
+		// reads are committed right away but keep half the buffer open.
+		window = socketState[s].RX_avg * 4;
+		if (window < size / 8) window = size / 8;
+		if (window > size / 2) window = size / 2;
+		return window;
+	default:
+		return socketState[s].RX_value;
+	}
+}
+
+// A value of 0 selects the default: 250 bytes for RecvFixed, 25% of
+// the buffer for RecvFraction.  RecvAdaptive ignores the value.
+//
+void EthernetClass::setRecvPolicy(EthernetRecvPolicy policy, uint16_t value)
+{
+	if (value == 0) value = (policy == RecvFraction) ? 25 : 250;
+	_recvPolicy = policy;
+	_recvValue = value;
+}
+
+void EthernetClass::socketSetRecvPolicy(uint8_t s, EthernetRecvPolicy policy, uint16_t value)
+{
+	SOCKET_LOCK(s);
+	if (value == 0) value = (policy == RecvFraction) ? 25 : 250;
+	socketState[s].RX_policy = policy;
+	socketState[s].RX_value = value;
+}
+
+EthernetRecvStats EthernetClass::socketRecvStats(uint8_t s)
+{
+	SOCKET_LOCK(s);
+	EthernetRecvStats stats;
+	stats.reads = socketState[s].RX_reads;
+	stats.commits = socketState[s].RX_commits;
+	stats.window = recvWindow(s);
+	return stats;
+}
+
+// Clear the state of a socket that was just opened
+void EthernetClass::resetState(uint8_t s)
+{
+	socketState[s].RX_RSR = 0;
+	socketState[s].RX_RD  = _w5x00->readSnRX_RD(s); // always zero?
+	socketState[s].RX_inc = 0;
+	socketState[s].TX_FSR = 0;
+	socketState[s].RX_policy = _recvPolicy;
+	socketState[s].RX_value = _recvValue;
+	socketState[s].RX_avg = 0;
+	socketState[s].RX_reads = 0;
+	socketState[s].RX_commits = 0;
+	if (socketState[s].KA_time && _w5x00->chip() == CHIP_W5500) {
+		_w5x00->writeSnKPALVTR(s, 0);
+	}
+	socketState[s].KA_time = 0;
+	socketState[s].TX_timeout = 0;
+#if ETHERNET_SOCKET_STATS
+	socketState[s].closeStart = 0;
+#endif
+	if (socketState[s].TX_opts) {
+		_w5x00->writeSnMSSR(s, 0);
+		_w5x00->writeSnTOS(s, 0);
+		_w5x00->writeSnTTL(s, 128);
+		socketState[s].TX_opts = 0;
+	}
+}
+
+void EthernetClass::socketSetOptions(uint8_t s, const EthernetSocketOptions &options)
+{
+	SOCKET_LOCK(s);
+	_w5x00->beginTransaction();
+	_w5x00->writeSnMSSR(s, options.mss);
+	_w5x00->writeSnTOS(s, options.tos);
+	_w5x00->writeSnTTL(s, options.ttl ? options.ttl : 128);
+	_w5x00->endTransaction();
+	socketState[s].TX_opts = 1;
+	socketState[s].TX_timeout = options.timeout;
+}
+
+EthernetSocketStats EthernetClass::socketStats(uint8_t s)
+{
+	SOCKET_LOCK(s);
+#if ETHERNET_SOCKET_STATS
+	EthernetSocketStats stats = socketState[s].stats;
+	stats.spiOps = _w5x00->sockSpiOps[s];
+	stats.spiBytes = _w5x00->sockSpiBytes[s];
+	return stats;
+#else
+	(void)s;
+	return EthernetSocketStats();
+#endif
+}
+
+uint8_t EthernetClass::socketStats(EthernetSocketStats *stats, uint8_t max)
+{
+	uint8_t n = maxSocketNum();
+	if (n > max) n = max;
+	for (uint8_t s = 0; s < n; s++) {
+		stats[s] = socketStats(s);
+	}
+	return n;
+}
+
+void EthernetClass::socketResetStats(uint8_t s)
+{
+	SOCKET_LOCK(s);
+#if ETHERNET_SOCKET_STATS
+	socketState[s].stats = EthernetSocketStats();
+	_w5x00->sockSpiOps[s] = 0;
+	_w5x00->sockSpiBytes[s] = 0;
+#else
+	(void)s;
+#endif
+}
+
+#if ETHERNET_LOCKING
+void EthernetClass::setLocking(EthernetLocking *policy)
+{
+	_locking = policy;
+	_w5x00->setLock(policy ? policy->chipLock() : NULL);
+}
+#endif
+
+void EthernetClass::socketSetKeepAlive(uint8_t s, uint16_t seconds)
+{
+	SOCKET_LOCK(s);
+	uint16_t units = (seconds + 4) / 5;
+	if (units > 255) units = 255;
+	socketState[s].KA_time = units;
+	socketState[s].KA_last = millis();
+	if (_w5x00->chip() == CHIP_W5500) {
+		_w5x00->beginTransaction();
+		_w5x00->writeSnKPALVTR(s, units);
+		_w5x00->endTransaction();
+	}
+}
+
+// Software keep-alive for chips without a keep-alive timer, called from
+// maintain().  A dead peer makes the chip time out and close the socket.
+//
+void EthernetClass::keepAlive()
+{
+	if (_w5x00->chip() == CHIP_W5500) return;
+	uint32_t now = millis();
+	for (uint8_t s = 0; s < maxSocketNum(); s++) {
+		SOCKET_LOCK(s);
+		if (!socketState[s].KA_time) continue;
+		if (now - socketState[s].KA_last < socketState[s].KA_time * 5000UL) continue;
+		socketState[s].KA_last = now;
+		_w5x00->beginTransaction();
+		if (_w5x00->readSnSR(s) == SnSR::ESTABLISHED) {
+			_w5x00->execCmdSn(s, Sock_SEND_KEEP);
+		}
+		_w5x00->endTransaction();
+	}
+}
+
+// Receive as many complete UDP datagrams as fit in buf.  The receive buffer
+// is read with one bulk transfer and RX_RD is committed once for all of them,
+// instead of an 8 byte header read and payload reads for every datagram.
+//
+uint8_t EthernetClass::socketRecvUDPBatch(uint8_t s, uint8_t *buf, uint16_t len, EthernetUDPPacketInfo *packets, uint8_t maxPackets)
+{
+	SOCKET_LOCK(s);
+	uint8_t count = 0;
+	uint16_t used = 0;
+
+	_w5x00->beginTransaction();
+	uint16_t rsr = getSnRX_RSR(s);
+	uint16_t avail = rsr - socketState[s].RX_inc;
+	socketState[s].RX_RSR = avail;
+	if (avail > len) avail = len; // more data available than buffer length
+	if (avail >= 8) {
+		read_data(s, socketState[s].RX_RD, buf, avail);
+		// Every datagram is preceded by an 8 byte header:
+		// remote IP (4), remote port (2) and payload length (2)
+		while (count < maxPackets && used + 8 <= avail) {
+			uint16_t size = (buf[used + 6] << 8) | buf[used + 7];
+			if (used + 8 + size > avail) break; // datagram not completely in buf
+			packets[count].remoteIP = IPAddress(buf + used);
+			packets[count].remotePort = (buf[used + 4] << 8) | buf[used + 5];
+			packets[count].offset = used + 8;
+			packets[count].length = size;
+			used += 8 + size;
+			count++;
+		}
+	}
+	if (used > 0) {
+		socketState[s].RX_RD += used;
+		socketState[s].RX_RSR -= used;
+		socketState[s].RX_reads++;
+		SOCKET_STAT(s, rxBytes, used);
+		recvCommit(s);
+	}
+	_w5x00->endTransaction();
+	return count;
+}
+
 uint16_t EthernetClass::socketRecvAvailable(uint8_t s)
 {
+	SOCKET_LOCK(s);
 	uint16_t ret = socketState[s].RX_RSR;
 	if (ret == 0) {
 		_w5x00->beginTransaction();
@@ -326,14 +638,42 @@ uint16_t EthernetClass::socketRecvAvailable(uint8_t s)
 	return ret;
 }
 
+uint16_t EthernetClass::socketRecvPeek(uint8_t s, uint8_t *buf, uint16_t len)
+{
+	SOCKET_LOCK(s);
+	_w5x00->beginTransaction();
+	uint16_t rsr = getSnRX_RSR(s);
+	uint16_t ret = rsr - socketState[s].RX_inc;
+	socketState[s].RX_RSR = ret;
+	if (ret > len) ret = len;
+	if (ret > 0) read_data(s, socketState[s].RX_RD, buf, ret);
+	_w5x00->endTransaction();
+	return ret;
+}
+
+void EthernetClass::socketRecvSkip(uint8_t s, uint16_t len)
+{
+	SOCKET_LOCK(s);
+	if (len == 0) return;
+	_w5x00->beginTransaction();
+	socketState[s].RX_RD += len;
+	socketState[s].RX_RSR -= len;
+	socketState[s].RX_reads++;
+	SOCKET_STAT(s, rxBytes, len);
+	recvCommit(s);
+	_w5x00->endTransaction();
+}
+
 // get the first byte in the receive queue (no checking)
 //
 uint8_t EthernetClass::socketPeek(uint8_t s)
 {
+	SOCKET_LOCK(s);
 	uint8_t b;
 	_w5x00->beginTransaction();
 	uint16_t ptr = socketState[s].RX_RD;
 	_w5x00->read((ptr & _w5x00->SMASK) + _w5x00->RBASE(s), &b, 1);
+	_w5x00->sockSpiStat(s, 1);
 	_w5x00->endTransaction();
 	return b;
 }
@@ -371,7 +711,9 @@ void EthernetClass::write_data(uint8_t s, uint16_t data_offset, const uint8_t *d
 		uint16_t size = _w5x00->SSIZE - offset;
 		_w5x00->write(dstAddr, data, size);
 		_w5x00->write(_w5x00->SBASE(s), data + size, len - size);
+		_w5x00->sockSpiStat(s, 0);
 	}
+	_w5x00->sockSpiStat(s, len);
 	ptr += len;
 	_w5x00->writeSnTX_WR(s, ptr);
 }
@@ -382,9 +724,13 @@ void EthernetClass::write_data(uint8_t s, uint16_t data_offset, const uint8_t *d
  */
 uint16_t EthernetClass::socketSend(uint8_t s, const uint8_t * buf, uint16_t len)
 {
+	SOCKET_LOCK(s);
 	uint8_t status=0;
 	uint16_t ret=0;
 	uint16_t freesize=0;
+	uint16_t timeout = socketState[s].TX_timeout;
+	uint32_t start = millis();
+	bool full = false;
 
 	if (len > _w5x00->SSIZE) {
 		ret = _w5x00->SSIZE; // check size not to exceed MAX size.
@@ -402,6 +748,14 @@ uint16_t EthernetClass::socketSend(uint8_t s, const uint8_t * buf, uint16_t len)
 			ret = 0;
 			break;
 		}
+		if (freesize < ret && !full) {
+			full = true;
+			SOCKET_STAT(s, txFull, 1);
+		}
+		if (timeout && freesize < ret && millis() - start >= timeout) {
+			socketClose(s);
+			return 0;
+		}
 		yield();
 	} while (freesize < ret);
 
@@ -409,6 +763,11 @@ uint16_t EthernetClass::socketSend(uint8_t s, const uint8_t * buf, uint16_t len)
 	_w5x00->beginTransaction();
 	write_data(s, 0, (uint8_t *)buf, ret);
 	_w5x00->execCmdSn(s, Sock_SEND);
+	SOCKET_STAT(s, txBytes, ret);
+	SOCKET_STAT(s, sendCmds, 1);
+#if ETHERNET_SOCKET_STATS
+	uint32_t sent = micros();
+#endif
 
 	/* +2008.01 bj */
 	while ( (_w5x00->readSnIR(s) & SnIR::SEND_OK) != SnIR::SEND_OK ) {
@@ -417,6 +776,11 @@ uint16_t EthernetClass::socketSend(uint8_t s, const uint8_t * buf, uint16_t len)
 			_w5x00->endTransaction();
 			return 0;
 		}
+		if (timeout && millis() - start >= timeout) {
+			_w5x00->execCmdSn(s, Sock_CLOSE);
+			_w5x00->endTransaction();
+			return 0;
+		}
 		_w5x00->endTransaction();
 		yield();
 		_w5x00->beginTransaction();
@@ -424,18 +788,62 @@ uint16_t EthernetClass::socketSend(uint8_t s, const uint8_t * buf, uint16_t len)
 	/* +2008.01 bj */
 	_w5x00->writeSnIR(s, SnIR::SEND_OK);
 	_w5x00->endTransaction();
+	SOCKET_STAT(s, sendWait, micros() - sent);
+	socketState[s].KA_last = millis();
+	return ret;
+}
+
+uint16_t EthernetClass::socketSendNoWait(uint8_t s, const uint8_t * buf, uint16_t len)
+{
+	SOCKET_LOCK(s);
+	uint16_t freesize;
+	uint8_t status;
+
+	_w5x00->beginTransaction();
+	freesize = getSnTX_FSR(s);
+	status = _w5x00->readSnSR(s);
+	if ((status != SnSR::ESTABLISHED) && (status != SnSR::CLOSE_WAIT)) {
+		freesize = 0;
+	}
+	if (len > freesize) len = freesize;
+	if (len > 0) {
+		write_data(s, 0, buf, len);
+		_w5x00->execCmdSn(s, Sock_SEND);
+		SOCKET_STAT(s, txBytes, len);
+		SOCKET_STAT(s, sendCmds, 1);
+	}
+	_w5x00->endTransaction();
+	return len;
+}
+
+int EthernetClass::socketSendStatus(uint8_t s)
+{
+	SOCKET_LOCK(s);
+	int ret = -1;
+
+	_w5x00->beginTransaction();
+	if (_w5x00->readSnIR(s) & SnIR::SEND_OK) {
+		_w5x00->writeSnIR(s, SnIR::SEND_OK);
+		socketState[s].KA_last = millis();
+		ret = 1;
+	} else if (_w5x00->readSnSR(s) == SnSR::CLOSED) {
+		ret = 0;
+	}
+	_w5x00->endTransaction();
 	return ret;
 }
 
 uint16_t EthernetClass::socketSendAvailable(uint8_t s)
 {
+	SOCKET_LOCK(s);
 	uint8_t status=0;
 	uint16_t freesize=0;
 	_w5x00->beginTransaction();
 	freesize = getSnTX_FSR(s);
 	status = _w5x00->readSnSR(s);
 	_w5x00->endTransaction();
-	if ((status == SnSR::ESTABLISHED) || (status == SnSR::CLOSE_WAIT)) {
+	if ((status == SnSR::ESTABLISHED) || (status == SnSR::CLOSE_WAIT) ||
+	  (status == SnSR::UDP) || (status == SnSR::IPRAW) || (status == SnSR::MACRAW)) {
 		return freesize;
 	}
 	return 0;
@@ -443,6 +851,7 @@ uint16_t EthernetClass::socketSendAvailable(uint8_t s)
 
 uint16_t EthernetClass::socketBufferData(uint8_t s, uint16_t offset, const uint8_t* buf, uint16_t len)
 {
+	SOCKET_LOCK(s);
 	//Serial.printf("  bufferData, offset=%d, len=%d\n", offset, len);
 	uint16_t ret =0;
 	_w5x00->beginTransaction();
@@ -454,11 +863,108 @@ uint16_t EthernetClass::socketBufferData(uint8_t s, uint16_t offset, const uint8
 	}
 	write_data(s, offset, buf, ret);
 	_w5x00->endTransaction();
+	if (ret < len) SOCKET_STAT(s, txFull, 1);
+	SOCKET_STAT(s, txBytes, ret);
+	return ret;
+}
+
+uint16_t EthernetClass::socketBufferDataAsync(uint8_t s, uint16_t offset, const uint8_t* buf, uint16_t len)
+{
+	SOCKET_LOCK(s);
+	uint16_t ret = 0;
+	if (!socketAsyncPoll()) return 0; // still busy with the previous one
+	_w5x00->beginTransaction();
+	uint16_t txfree = getSnTX_FSR(s);
+	if (len > txfree) {
+		ret = txfree; // check size not to exceed MAX size.
+	} else {
+		ret = len;
+	}
+	if (ret == 0) {
+		_w5x00->endTransaction();
+		return 0;
+	}
+	uint16_t ptr = _w5x00->readSnTX_WR(s) + offset;
+	uint16_t mask = ptr & _w5x00->SMASK;
+	uint16_t dstAddr = mask + _w5x00->SBASE(s);
+	if (_w5x00->hasOffsetAddressMapping() || mask + ret <= _w5x00->SSIZE) {
+		_w5x00->writeAsync(dstAddr, buf, ret);
+	} else {
+		// Wrap around circular buffer, only on chips without background transfers
+		uint16_t size = _w5x00->SSIZE - mask;
+		_w5x00->write(dstAddr, buf, size);
+		_w5x00->write(_w5x00->SBASE(s), buf + size, ret - size);
+		_w5x00->sockSpiStat(s, 0);
+	}
+	_w5x00->sockSpiStat(s, ret);
+	if (ret < len) SOCKET_STAT(s, txFull, 1);
+	SOCKET_STAT(s, txBytes, ret);
+	// The transaction stays open until socketAsyncPoll() finishes the transfer
+	_asyncSocket = s;
+	_asyncRecv = false;
+	_asyncPtr = ptr + ret;
+	_asyncLen = ret;
 	return ret;
 }
 
+int EthernetClass::socketRecvAsync(uint8_t s, uint8_t *buf, int16_t len)
+{
+	SOCKET_LOCK(s);
+	if (!socketAsyncPoll()) return -2; // still busy with the previous one
+	// Check how much data is available
+	int ret = socketState[s].RX_RSR;
+	_w5x00->beginTransaction();
+	if (ret < len) {
+		uint16_t rsr = getSnRX_RSR(s);
+		ret = rsr - socketState[s].RX_inc;
+		socketState[s].RX_RSR = ret;
+	}
+	if (ret == 0) {
+		uint8_t status = _w5x00->readSnSR(s);
+		if ( status == SnSR::LISTEN || status == SnSR::CLOSED ||
+		  status == SnSR::CLOSE_WAIT ) {
+			ret = 0;
+		} else {
+			ret = -1;
+		}
+		_w5x00->endTransaction();
+		return ret;
+	}
+	if (ret > len) ret = len; // more data available than buffer length
+	uint16_t mask = socketState[s].RX_RD & _w5x00->SMASK;
+	uint16_t srcAddr = _w5x00->RBASE(s) + mask;
+	if (_w5x00->hasOffsetAddressMapping() || mask + ret <= _w5x00->SSIZE) {
+		_w5x00->readAsync(srcAddr, buf, ret);
+		_w5x00->sockSpiStat(s, ret);
+	} else {
+		read_data(s, socketState[s].RX_RD, buf, ret);
+	}
+	_asyncSocket = s;
+	_asyncRecv = true;
+	_asyncLen = ret;
+	return ret;
+}
+
+bool EthernetClass::socketAsyncPoll()
+{
+	uint8_t s = _asyncSocket;
+	if (s >= _w5x00->maxSockNum()) return true;
+	if (!_w5x00->asyncDone()) return false;
+
+	if (_asyncRecv) {
+		recvAdvance(s, _asyncLen);
+	} else {
+		_w5x00->writeSnTX_WR(s, _asyncPtr);
+	}
+	_w5x00->endTransaction();
+	_asyncSocket = _w5x00->maxSockNum();
+	if (_asyncCallback) _asyncCallback(s, _asyncLen);
+	return true;
+}
+
 bool EthernetClass::socketStartUDP(uint8_t s, uint8_t* addr, uint16_t port)
 {
+	SOCKET_LOCK(s);
 	if ( ((addr[0] == 0x00) && (addr[1] == 0x00) && (addr[2] == 0x00) && (addr[3] == 0x00)) ||
 	  ((port == 0x00)) ) {
 		return false;
@@ -470,10 +976,45 @@ bool EthernetClass::socketStartUDP(uint8_t s, uint8_t* addr, uint16_t port)
 	return true;
 }
 
-bool EthernetClass::socketSendUDP(uint8_t s)
+void EthernetClass::socketSetRemoteMAC(uint8_t s, const uint8_t *mac)
 {
+	SOCKET_LOCK(s);
+	uint8_t dhar[6];
+	memcpy(dhar, mac, 6);
 	_w5x00->beginTransaction();
-	_w5x00->execCmdSn(s, Sock_SEND);
+	_w5x00->writeSnDHAR(s, dhar);
+	_w5x00->endTransaction();
+}
+
+void EthernetClass::socketRemoteMAC(uint8_t s, uint8_t *mac)
+{
+	SOCKET_LOCK(s);
+	_w5x00->beginTransaction();
+	_w5x00->readSnDHAR(s, mac);
+	_w5x00->endTransaction();
+}
+
+bool EthernetClass::socketStartIPRAW(uint8_t s, uint8_t* addr)
+{
+	SOCKET_LOCK(s);
+	if ((addr[0] == 0x00) && (addr[1] == 0x00) && (addr[2] == 0x00) && (addr[3] == 0x00)) {
+		return false;
+	}
+	_w5x00->beginTransaction();
+	_w5x00->writeSnDIPR(s, addr);
+	_w5x00->endTransaction();
+	return true;
+}
+
+bool EthernetClass::socketSendUDP(uint8_t s, SockCMD cmd)
+{
+	SOCKET_LOCK(s);
+	_w5x00->beginTransaction();
+	_w5x00->execCmdSn(s, cmd);
+	SOCKET_STAT(s, sendCmds, 1);
+#if ETHERNET_SOCKET_STATS
+	uint32_t sent = micros();
+#endif
 
 	/* +2008.01 bj */
 	while ( (_w5x00->readSnIR(s) & SnIR::SEND_OK) != SnIR::SEND_OK ) {
@@ -492,8 +1033,36 @@ bool EthernetClass::socketSendUDP(uint8_t s)
 	/* +2008.01 bj */
 	_w5x00->writeSnIR(s, SnIR::SEND_OK);
 	_w5x00->endTransaction();
+	SOCKET_STAT(s, sendWait, micros() - sent);
 
 	//Serial.printf("sendUDP ok\n");
 	/* Sent ok */
 	return true;
 }
+
+void EthernetClass::socketSendUDPNoWait(uint8_t s, SockCMD cmd)
+{
+	SOCKET_LOCK(s);
+	_w5x00->beginTransaction();
+	_w5x00->execCmdSn(s, cmd);
+	SOCKET_STAT(s, sendCmds, 1);
+	_w5x00->endTransaction();
+}
+
+int EthernetClass::socketSendUDPStatus(uint8_t s)
+{
+	SOCKET_LOCK(s);
+	int ret = -1;
+
+	_w5x00->beginTransaction();
+	uint8_t ir = _w5x00->readSnIR(s);
+	if (ir & SnIR::SEND_OK) {
+		_w5x00->writeSnIR(s, SnIR::SEND_OK);
+		ret = 1;
+	} else if (ir & SnIR::TIMEOUT) {
+		_w5x00->writeSnIR(s, (SnIR::SEND_OK|SnIR::TIMEOUT));
+		ret = 0;
+	}
+	_w5x00->endTransaction();
+	return ret;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Bounded lock-free ring buffers used by EthernetTask to pass requests and
+// completions between tasks.  They only need the GCC __atomic builtins, so
+// they also build on a host (e.g. with pthreads) without the Arduino core.
+// On cores without compare-and-swap (Cortex-M0+ of the RP2040) the compiler
+// calls the __atomic helpers of the core for the MPSC push.
+
+#ifndef	ETHERNETQUEUE_H_INCLUDED
+#define	ETHERNETQUEUE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One producer and one consumer.  N must be a power of two.
+template <class T, size_t N>
+class EthernetSPSCQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  EthernetSPSCQueue() : _head(0), _tail(0) { }
+
+  // Producer: false if the queue is full
+  bool push(const T &item) {
+    size_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+    if (tail - __atomic_load_n(&_head, __ATOMIC_ACQUIRE) == N) return false;
+    _items[tail & (N - 1)] = item;
+    __atomic_store_n(&_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Consumer: false if the queue is empty
+  bool pop(T &item) {
+    size_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+    if (head == __atomic_load_n(&_tail, __ATOMIC_ACQUIRE)) return false;
+    item = _items[head & (N - 1)];
+    __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Only exact when called by the producer or the consumer
+  size_t count() {
+    return __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+  }
+
+private:
+  T _items[N];
+  size_t _head; // next to pop, only written by the consumer
+  size_t _tail; // next to push, only written by the producer
+};
+
+// Any number of producers and one consumer.  Every slot has a sequence
+// number that tells whose turn it is, so producers only contend on _tail
+// and a slow producer never blocks the others.  N must be a power of two.
+template <class T, size_t N>
+class EthernetMPSCQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  EthernetMPSCQueue() : _head(0), _tail(0) {
+    for (size_t i = 0; i < N; i++) _slots[i].seq = i;
+  }
+
+  // Any task: false if the queue is full
+  bool push(const T &item) {
+    size_t pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+    slot_t *slot;
+    for (;;) {
+      slot = &_slots[pos & (N - 1)];
+      size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+      ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+      if (diff == 0) {
+        // The slot is free, claim it by moving _tail on
+        if (__atomic_compare_exchange_n(&_tail, &pos, pos + 1, true,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+      } else if (diff < 0) {
+        return false; // the consumer has not popped this slot yet
+      } else {
+        pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+      }
+    }
+    slot->item = item;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Consumer: false if the queue is empty or the oldest push is not done
+  bool pop(T &item) {
+    slot_t *slot = &_slots[_head & (N - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != _head + 1) return false;
+    item = slot->item;
+    __atomic_store_n(&slot->seq, _head + N, __ATOMIC_RELEASE);
+    _head++;
+    return true;
+  }
+
+private:
+  typedef struct {
+    size_t seq;
+    T item;
+  } slot_t;
+
+  slot_t _slots[N];
+  size_t _head; // only used by the consumer
+  size_t _tail;
+};
+
+#endif
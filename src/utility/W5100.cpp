@@ -16,6 +16,7 @@ W5100Class::W5100Class(SPIClass &spi, uint8_t sspin, uint8_t maxSockNum){
 	this->spi = &spi;
 	ss_pin = sspin;
 	_maxSockNum = 4; // Max for W5100
+	setSPIClock(W5100_SPI_CLOCK);
 	if(maxSockNum < _maxSockNum){_maxSockNum = maxSockNum;}
 }
 
@@ -23,6 +24,7 @@ W5100Class::W5100Class(SPIClass &spi, uint8_t sspin){
 	this->spi = &spi;
 	ss_pin = sspin;
 	_maxSockNum = 4; // Max for W5100
+	setSPIClock(W5100_SPI_CLOCK);
 }
 
 // Chip dependant
@@ -40,14 +42,15 @@ uint8_t W5100Class::init(void)
 	// a 400 ms worst case maximum pulse length.  MAX811 has a worst
 	// case maximum 560 ms pulse length.  This delay is meant to wait
 	// until the reset pulse is ended.  If your hardware has a shorter
-	// reset time, this can be edited or removed.
-	delay(560);
+	// reset time, this can be changed with setResetDelay().  With
+	// setResetMode() or setResetPin() init() polls the chip instead.
+	if (!waitReady()) return 0;
 	//Serial.println("w5100 init");
 
 	//SPI.begin();	This should be done outside of the class
 	initSS();
 	resetSS();
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
+	beginTransaction();
 	
 	// Try a soft reset, if this works a chip is present. 
 	if (softReset()){
@@ -72,15 +75,39 @@ uint8_t W5100Class::init(void)
 	// pin wasn't high when a SD card or other SPI chip was used.
 	} else {
 		//Serial.println("no chip :-(");
-		spi->endTransaction();
+		endTransaction();
 		return 0; // no known chip is responding :-(
 	}
-	spi->endTransaction();
+	endTransaction();
 	_initialized = true;
 	//Serial.println("w5100 Initialized");
 	return 1; // successful init
 }
 
+// Chip dependant
+uint8_t W5100Class::detect(void)
+{
+	uint8_t ret = 0;
+
+	initSS();
+	resetSS();
+	beginTransaction();
+	// W5200 and W5500 accept these MR values as well, so only
+	// probe for a W5100 after the other chips were ruled out.
+	if (softReset()) {
+		writeMR(0x10);
+		if (readMR() == 0x10) {
+			writeMR(0x12);
+			if (readMR() == 0x12) {
+				writeMR(0x00);
+				if (readMR() == 0x00) ret = 1;
+			}
+		}
+	}
+	endTransaction();
+	return ret;
+}
+
 W5x00Linkstatus W5100Class::getLinkStatus()
 {
 	return UNKNOWN;
@@ -90,6 +117,8 @@ W5x00Linkstatus W5100Class::getLinkStatus()
 uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 {
 	uint8_t cmd[8];
+	uint16_t first = addr;
+	uint32_t start = traceStart();
 
 	for (uint16_t i=0; i<len; i++) {
 		setSS();
@@ -100,6 +129,7 @@ uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 		spi->transfer(buf[i]);
 		resetSS();
 	}
+	traceEnd(start, first, buf, len, W5X00_TRACE_WRITE);
 	return len;
 }
 
@@ -107,6 +137,8 @@ uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
 {
 	uint8_t cmd[4];
+	uint16_t first = addr;
+	uint32_t start = traceStart();
 
 	for (uint16_t i=0; i < len; i++) {
 		setSS();
@@ -127,10 +159,6 @@ uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
 		#endif
 		resetSS();
 	}
+	traceEnd(start, first, buf, len, 0);
 	return len;
 }
-
-// Generic
-void W5100Class::beginTransaction(){
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
-}
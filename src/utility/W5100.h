@@ -18,29 +18,27 @@
 #include <SPI.h>
 #include "W5x00.h"
 
-// Safe for all chips
-#define SPI_ETHERNET_SETTINGS SPISettings(14000000, MSBFIRST, SPI_MODE0)
-
-// Safe for W5200 and W5500, but too fast for W5100
-// Uncomment this if you know you'll never need W5100 support.
-// Higher SPI clock only results in faster transfer to hosts on a LAN
-// or with very low packet latency.  With ordinary internet latency,
-// the TCP window size & packet loss determine your overall speed.
-//#define SPI_ETHERNET_SETTINGS SPISettings(30000000, MSBFIRST, SPI_MODE0)
-
+// Default SPI clock, safe for all chips.  It can be changed for each
+// instance with setSPIClock() or setSPISettings().
+#define W5100_SPI_CLOCK 14000000
 
 // Arduino 101's SPI can not run faster than 8 MHz.
 #if defined(ARDUINO_ARCH_ARC32)
-#undef SPI_ETHERNET_SETTINGS
-#define SPI_ETHERNET_SETTINGS SPISettings(8000000, MSBFIRST, SPI_MODE0)
+#undef W5100_SPI_CLOCK
+#define W5100_SPI_CLOCK 8000000
 #endif
 
 // Arduino Zero can't use W5100-based shields faster than 8 MHz
 // https://github.com/arduino-libraries/Ethernet/issues/37#issuecomment-408036848
-// W5500 does seem to work at 12 MHz.  Delete this if only using W5500
 #if defined(__SAMD21G18A__)
-#undef SPI_ETHERNET_SETTINGS
-#define SPI_ETHERNET_SETTINGS SPISettings(8000000, MSBFIRST, SPI_MODE0)
+#undef W5100_SPI_CLOCK
+#define W5100_SPI_CLOCK 8000000
+#endif
+
+// Deprecated, the library no longer uses it.  The SPI settings are kept by
+// each chip instance, see W5x00Class::setSPISettings().
+#ifndef SPI_ETHERNET_SETTINGS
+#define SPI_ETHERNET_SETTINGS SPISettings(W5100_SPI_CLOCK, MSBFIRST, SPI_MODE0)
 #endif
 
 class W5100Class: public W5x00Class {
@@ -55,8 +53,6 @@ public:
 
   W5x00Linkstatus getLinkStatus();
 
-  void beginTransaction();
-
   uint16_t SBASE(uint8_t socknum) {
     return socknum * SSIZE + 0x4000;
   }
@@ -66,6 +62,10 @@ public:
 
   const bool hasOffsetAddressMapping(){return false;}
 
+  W5x00Chip chip() { return CHIP_W5100; }
+
+  uint8_t detect(void);
+
 private:
 
   uint16_t write(uint16_t addr, const uint8_t *buf, uint16_t len);
@@ -17,6 +17,7 @@ W5200Class::W5200Class(SPIClass &spi, uint8_t sspin, uint8_t maxSockNum){
 	this->spi = &spi;
 	ss_pin = sspin;
 	_maxSockNum = 8; // Max for W5200
+	setSPIClock(W5200_SPI_CLOCK);
 	if(maxSockNum < _maxSockNum){_maxSockNum = maxSockNum;}
 }
 
@@ -24,6 +25,7 @@ W5200Class::W5200Class(SPIClass &spi, uint8_t sspin){
 	this->spi = &spi;
 	ss_pin = sspin;
 	_maxSockNum = 8; // Max for W5200
+	setSPIClock(W5200_SPI_CLOCK);
 }
 
 // Chip dependant
@@ -41,14 +43,15 @@ uint8_t W5200Class::init(void)
 	// a 400 ms worst case maximum pulse length.  MAX811 has a worst
 	// case maximum 560 ms pulse length.  This delay is meant to wait
 	// until the reset pulse is ended.  If your hardware has a shorter
-	// reset time, this can be edited or removed.
-	delay(560);
+	// reset time, this can be changed with setResetDelay().  With
+	// setResetMode() or setResetPin() init() polls the chip instead.
+	if (!waitReady()) return 0;
 	//Serial.println("W5200 init");
 
 	//SPI.begin();	This should be done outside of the class
 	initSS();
 	resetSS();
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
+	beginTransaction();
 
 	// Attempt W5200 detection first, because W5200 does not properly
 	// reset its SPI state when CS goes high (inactive).  Communication
@@ -83,15 +86,28 @@ uint8_t W5200Class::init(void)
 	// pin wasn't high when a SD card or other SPI chip was used.
 	} else {
 		//Serial.println("no chip :-(");
-		spi->endTransaction();
+		endTransaction();
 		return 0; // no known chip is responding :-(
 	}
-	spi->endTransaction();
+	endTransaction();
 	_initialized = true;
 	//Serial.println("w5100 Initialized");
 	return 1; // successful init
 }
 
+// Chip dependant
+uint8_t W5200Class::detect(void)
+{
+	uint8_t ret = 0;
+
+	initSS();
+	resetSS();
+	beginTransaction();
+	if (softReset() && readVERSIONR_W5200() == 0x03) ret = 1;
+	endTransaction();
+	return ret;
+}
+
 W5x00Linkstatus W5200Class::getLinkStatus()
 {
 	uint8_t phystatus;
@@ -100,9 +116,9 @@ W5x00Linkstatus W5200Class::getLinkStatus()
 	if (!init()) return UNKNOWN;
 
 	// Get status
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
+	beginTransaction();
 	phystatus = readPSTATUS_W5200();
-	spi->endTransaction();
+	endTransaction();
 	if (phystatus & 0x20) return LINK_ON;
 	return LINK_OFF;
 }
@@ -111,6 +127,7 @@ W5x00Linkstatus W5200Class::getLinkStatus()
 uint16_t W5200Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 {
 	uint8_t cmd[8];
+	uint32_t start = traceStart();
 
 	setSS();
 	cmd[0] = addr >> 8;
@@ -127,6 +144,7 @@ uint16_t W5200Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 	}
 #endif
 	resetSS();
+	traceEnd(start, addr, buf, len, W5X00_TRACE_WRITE);
 	return len;
 }
 
@@ -134,6 +152,7 @@ uint16_t W5200Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 uint16_t W5200Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
 {
 	uint8_t cmd[4];
+	uint32_t start = traceStart();
 
 	setSS();
 	cmd[0] = addr >> 8;
@@ -141,14 +160,14 @@ uint16_t W5200Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
 	cmd[2] = (len >> 8) & 0x7F;
 	cmd[3] = len & 0xFF;
 	spi->transfer(cmd, 4);
+#ifdef SPI_HAS_TRANSFER_BUF
+	spi->transfer(NULL, buf, len);
+#else
 	memset(buf, 0, len);
 	spi->transfer(buf, len);
+#endif
 	resetSS();
+	traceEnd(start, addr, buf, len, 0);
 
 	return len;
 }
-
-// Generic
-void W5200Class::beginTransaction(){
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
-}
@@ -18,20 +18,17 @@
 #include <SPI.h>
 #include "W5x00.h"
 
-// Safe for all chips
-//#define SPI_ETHERNET_SETTINGS SPISettings(14000000, MSBFIRST, SPI_MODE0)
-
-// Safe for W5200 and W5500, but too fast for W5100
-// Uncomment this if you know you'll never need W5100 support.
+// Default SPI clock, too fast for W5100.  It can be changed for each
+// instance with setSPIClock() or setSPISettings().
 //  Higher SPI clock only results in faster transfer to hosts on a LAN
 //  or with very low packet latency.  With ordinary internet latency,
 //  the TCP window size & packet loss determine your overall speed.
-#define SPI_ETHERNET_SETTINGS SPISettings(30000000, MSBFIRST, SPI_MODE0)
+#define W5200_SPI_CLOCK 30000000
 
 // Arduino 101's SPI can not run faster than 8 MHz.
 #if defined(ARDUINO_ARCH_ARC32)
-#undef SPI_ETHERNET_SETTINGS
-#define SPI_ETHERNET_SETTINGS SPISettings(8000000, MSBFIRST, SPI_MODE0)
+#undef W5200_SPI_CLOCK
+#define W5200_SPI_CLOCK 8000000
 #endif
 
 class W5200Class: public W5x00Class {
@@ -45,8 +42,6 @@ public:
 
   W5x00Linkstatus getLinkStatus();
 
-  void beginTransaction();
-
   uint16_t SBASE(uint8_t socknum) {
     return socknum * SSIZE + 0x8000;
   }
@@ -56,6 +51,12 @@ public:
 
   const bool hasOffsetAddressMapping(){return false;}
 
+  W5x00Chip chip() { return CHIP_W5200; }
+
+  uint8_t macFilterMode() { return SnMR::MF; }
+
+  uint8_t detect(void);
+
 private:
 
   uint16_t write(uint16_t addr, const uint8_t *buf, uint16_t len);
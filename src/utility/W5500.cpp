@@ -18,6 +18,7 @@ W5500Class::W5500Class(SPIClass &spi, uint8_t sspin, uint8_t maxSockNum){
 	this->spi = &spi;
 	ss_pin = sspin;
 	_maxSockNum = 8; // Max for W5500
+	setSPIClock(W5500_SPI_CLOCK);
 	if(maxSockNum < _maxSockNum){_maxSockNum = maxSockNum;}
 }
 
@@ -25,6 +26,7 @@ W5500Class::W5500Class(SPIClass &spi, uint8_t sspin){
 	this->spi = &spi;
 	ss_pin = sspin;
 	_maxSockNum = 8; // Max for W5500
+	setSPIClock(W5500_SPI_CLOCK);
 }
 
 // Chip dependant
@@ -42,14 +44,15 @@ uint8_t W5500Class::init(void)
 	// a 400 ms worst case maximum pulse length.  MAX811 has a worst
 	// case maximum 560 ms pulse length.  This delay is meant to wait
 	// until the reset pulse is ended.  If your hardware has a shorter
-	// reset time, this can be edited or removed.
-	delay(560);
+	// reset time, this can be changed with setResetDelay().  With
+	// setResetMode() or setResetPin() init() polls the chip instead.
+	if (!waitReady()) return 0;
 	//Serial.println("w5500 init");
 
 	//SPI.begin();	This should be done outside of the class
 	initSS();
 	resetSS();
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
+	beginTransaction();
 	
 	// Try a soft reset, if this works a chip is present. 
 	if (softReset()){
@@ -65,6 +68,14 @@ uint8_t W5500Class::init(void)
 		}
 		SMASK = SSIZE - 1;
 		
+		// Control bytes of the socket buffers, the socket number is
+		// found by shifting the buffer address by the buffer size.
+		for (_bufShift = 0; (1 << _bufShift) < SSIZE; _bufShift++) ;
+		for (i=0; i<8; i++) {
+			_txControl[i] = (i << 5) | 0x10;
+			_rxControl[i] = (i << 5) | 0x18;
+		}
+
 		for (i=0; i<_maxSockNum; i++) {
 			writeSnRX_SIZE(i, SSIZE >> 10);
 			writeSnTX_SIZE(i, SSIZE >> 10);
@@ -79,15 +90,28 @@ uint8_t W5500Class::init(void)
 	// pin wasn't high when a SD card or other SPI chip was used.
 	} else {
 		//Serial.println("no chip :-(");
-		spi->endTransaction();
+		endTransaction();
 		return 0; // no known chip is responding :-(
 	}
-	spi->endTransaction();
+	endTransaction();
 	_initialized = true;
 	//Serial.println("w5500 Initialized");
 	return 1; // successful init
 }
 
+// Chip dependant
+uint8_t W5500Class::detect(void)
+{
+	uint8_t ret = 0;
+
+	initSS();
+	resetSS();
+	beginTransaction();
+	if (softReset() && readVERSIONR_W5500() == 0x04) ret = 1;
+	endTransaction();
+	return ret;
+}
+
 W5x00Linkstatus W5500Class::getLinkStatus()
 {
 	uint8_t phystatus;
@@ -96,61 +120,49 @@ W5x00Linkstatus W5500Class::getLinkStatus()
 	if (!init()) return UNKNOWN;
 
 	// Get status
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
+	beginTransaction();
 	phystatus = readPHYCFGR_W5500();
-	spi->endTransaction();
+	endTransaction();
 	if (phystatus & 0x01) return LINK_ON;
 	return LINK_OFF;
 }
 
 // Chip dependant
-uint16_t W5500Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
+// Fill in the 3 byte header of an SPI frame: address and control byte.
+// rw is 0x04 for a write and 0x00 for a read.
+void W5500Class::header(uint16_t addr, uint8_t *cmd, uint8_t rw)
 {
-	uint8_t cmd[8];
-
-	setSS();
 	if (addr < 0x100) {
 		// common registers 00nn
 		cmd[0] = 0;
 		cmd[1] = addr & 0xFF;
-		cmd[2] = 0x04;
+		cmd[2] = 0x00 | rw;
 	} else if (addr < 0x8000) {
 		// socket registers  10nn, 11nn, 12nn, 13nn, etc
 		cmd[0] = 0;
 		cmd[1] = addr & 0xFF;
-		cmd[2] = ((addr >> 3) & 0xE0) | 0x0C;
-	} else if (addr < 0xC000) {
+		cmd[2] = ((addr >> 3) & 0xE0) | 0x08 | rw;
+	} else {
 		// transmit buffers  8000-87FF, 8800-8FFF, 9000-97FF, etc
 		//  10## #nnn nnnn nnnn
+		// receive buffers   C000-C7FF, C800-CFFF, D000-D7FF, etc
 		cmd[0] = addr >> 8;
 		cmd[1] = addr & 0xFF;
+		uint8_t sock = (addr & 0x3FFF) >> _bufShift;
+		cmd[2] = (addr < 0xC000 ? _txControl[sock] : _rxControl[sock]) | rw;
+	}
+}
 
-		if(_maxSockNum <= 1){
-			cmd[2] = 0x14;  
-		}else if(_maxSockNum <= 2){
-			cmd[2] = ((addr >> 8) & 0x20) | 0x14; // 8K buffers
-		}else if(_maxSockNum <= 4){
-			cmd[2] = ((addr >> 7) & 0x60) | 0x14; // 4K buffers
-		}else{
-			cmd[2] = ((addr >> 6) & 0xE0) | 0x14; // 2K buffers
-		}
-
-	} else {
-		// receive buffers
-		cmd[0] = addr >> 8;
-		cmd[1] = addr & 0xFF;
-
-		if(_maxSockNum <= 1){
-			cmd[2] = 0x1C;    
-		}else if(_maxSockNum <= 2){
-			cmd[2] = ((addr >> 8) & 0x20) | 0x1C; // 8K buffers
-		}else if(_maxSockNum <= 4){
-			cmd[2] = ((addr >> 7) & 0x60) | 0x1C; // 4K buffers
-		}else{
-			cmd[2] = ((addr >> 6) & 0xE0) | 0x1C; // 2K buffers
-		}
+// Chip dependant
+uint16_t W5500Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
+{
+	uint8_t cmd[8];
 
-	}
+	// Wait for a background transfer, it still has the chip selected
+	while (!asyncDone()) ;
+	uint32_t start = traceStart();
+	setSS();
+	header(addr, cmd, 0x04);
 	if (len <= 5) {
 		for (uint8_t i=0; i < len; i++) {
 			cmd[i + 3] = buf[i];
@@ -168,6 +180,7 @@ uint16_t W5500Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 #endif
 	}
 	resetSS();
+	traceEnd(start, addr, buf, len, W5X00_TRACE_WRITE);
 
 	return len;
 }
@@ -177,56 +190,86 @@ uint16_t W5500Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
 {
 	uint8_t cmd[4];
 
+	while (!asyncDone()) ;
+	uint32_t start = traceStart();
 	setSS();
-	if (addr < 0x100) {
-		// common registers 00nn
-		cmd[0] = 0;
-		cmd[1] = addr & 0xFF;
-		cmd[2] = 0x00;
-	} else if (addr < 0x8000) {
-		// socket registers  10nn, 11nn, 12nn, 13nn, etc
-		cmd[0] = 0;
-		cmd[1] = addr & 0xFF;
-		cmd[2] = ((addr >> 3) & 0xE0) | 0x08;
-	} else if (addr < 0xC000) {
-		// transmit buffers  8000-87FF, 8800-8FFF, 9000-97FF, etc
-		//  10## #nnn nnnn nnnn
-		cmd[0] = addr >> 8;
-		cmd[1] = addr & 0xFF;
+	header(addr, cmd, 0x00);
+	spi->transfer(cmd, 3);
+#ifdef SPI_HAS_TRANSFER_BUF
+	spi->transfer(NULL, buf, len);
+#else
+	memset(buf, 0, len);
+	spi->transfer(buf, len);
+#endif
+	resetSS();
+	traceEnd(start, addr, buf, len, 0);
+	return len;
+}
 
-		if(_maxSockNum <= 1){
-			cmd[2] = 0x10;                       // 16K buffers
-		}else if(_maxSockNum <= 2){
-			cmd[2] = ((addr >> 8) & 0x20) | 0x10; // 8K buffers
-		}else if(_maxSockNum <= 4){
-			cmd[2] = ((addr >> 7) & 0x60) | 0x10; // 4K buffers
-		}else{
-			cmd[2] = ((addr >> 6) & 0xE0) | 0x10; // 2K buffers
-		}
+// Chip dependant
+// Start clocking the data in the background, the chip stays selected
+// until asyncDone() sees the transfer has finished.
+uint16_t W5500Class::writeAsync(uint16_t addr, const uint8_t *buf, uint16_t len)
+{
+	uint8_t cmd[3];
 
-	} else {
-		// receive buffers
-		cmd[0] = addr >> 8;
-		cmd[1] = addr & 0xFF;
-		
-		if(_maxSockNum <= 1){
-			cmd[2] = 0x18;                       // 16K buffers
-		}else if(_maxSockNum <= 2){
-			cmd[2] = ((addr >> 8) & 0x20) | 0x18; // 8K buffers
-		}else if(_maxSockNum <= 4){
-			cmd[2] = ((addr >> 7) & 0x60) | 0x18; // 4K buffers
-		}else{
-			cmd[2] = ((addr >> 6) & 0xE0) | 0x18; // 2K buffers
-		}
+	if (!_async || len < W5X00_ASYNC_MIN_SIZE) return write(addr, buf, len);
+	while (!asyncDone()) ;
+	uint32_t start = traceStart();
+	setSS();
+	header(addr, cmd, 0x04);
+	spi->transfer(cmd, 3);
+	if (_async->start(spi, buf, NULL, len)) {
+		_asyncBusy = true;
+		traceEnd(start, addr, buf, len, W5X00_TRACE_WRITE | W5X00_TRACE_ASYNC);
+		return len;
+	}
+	// The backend can't do it now, clock the data out ourselves
+#ifdef SPI_HAS_TRANSFER_BUF
+	spi->transfer(buf, NULL, len);
+#else
+	for (uint16_t i=0; i < len; i++) {
+		spi->transfer(buf[i]);
 	}
+#endif
+	resetSS();
+	traceEnd(start, addr, buf, len, W5X00_TRACE_WRITE);
+	return len;
+}
+
+// Chip dependant
+uint16_t W5500Class::readAsync(uint16_t addr, uint8_t *buf, uint16_t len)
+{
+	uint8_t cmd[3];
+
+	if (!_async || len < W5X00_ASYNC_MIN_SIZE) return read(addr, buf, len);
+	while (!asyncDone()) ;
+	uint32_t start = traceStart();
+	setSS();
+	header(addr, cmd, 0x00);
 	spi->transfer(cmd, 3);
+	if (_async->start(spi, NULL, buf, len)) {
+		_asyncBusy = true;
+		traceEnd(start, addr, buf, len, W5X00_TRACE_ASYNC);
+		return len;
+	}
+#ifdef SPI_HAS_TRANSFER_BUF
+	spi->transfer(NULL, buf, len);
+#else
 	memset(buf, 0, len);
 	spi->transfer(buf, len);
+#endif
 	resetSS();
+	traceEnd(start, addr, buf, len, 0);
 	return len;
 }
 
-// Generic
-void W5500Class::beginTransaction(){
-	spi->beginTransaction(SPI_ETHERNET_SETTINGS);
+// Chip dependant
+bool W5500Class::asyncDone()
+{
+	if (_asyncBusy && _async->done()) {
+		resetSS();
+		_asyncBusy = false;
+	}
+	return !_asyncBusy;
 }
@@ -19,20 +19,17 @@
 #include <SPI.h>
 #include "W5x00.h"
 
-// Safe for all chips
-//#define SPI_ETHERNET_SETTINGS SPISettings(14000000, MSBFIRST, SPI_MODE0)
-
-// Safe for W5200 and W5500, but too fast for W5100
-// Uncomment this if you know you'll never need W5100 support.
+// Default SPI clock, too fast for W5100.  It can be changed for each
+// instance with setSPIClock() or setSPISettings().
 //  Higher SPI clock only results in faster transfer to hosts on a LAN
 //  or with very low packet latency.  With ordinary internet latency,
 //  the TCP window size & packet loss determine your overall speed.
-#define SPI_ETHERNET_SETTINGS SPISettings(30000000, MSBFIRST, SPI_MODE0)
+#define W5500_SPI_CLOCK 30000000
 
 // Arduino 101's SPI can not run faster than 8 MHz.
 #if defined(ARDUINO_ARCH_ARC32)
-#undef SPI_ETHERNET_SETTINGS
-#define SPI_ETHERNET_SETTINGS SPISettings(8000000, MSBFIRST, SPI_MODE0)
+#undef W5500_SPI_CLOCK
+#define W5500_SPI_CLOCK 8000000
 #endif
 
 class W5500Class: public W5x00Class {
@@ -50,8 +47,6 @@ public:
 
   W5x00Linkstatus getLinkStatus();
 
-  void beginTransaction();
-
   uint16_t SBASE(uint8_t socknum) {
     return socknum * SSIZE + 0x8000;
   }
@@ -61,8 +56,27 @@ public:
 
   const bool hasOffsetAddressMapping(){return true;}
 
+  W5x00Chip chip() { return CHIP_W5500; }
+
+  uint8_t macFilterMode() { return SnMR::MFEN; }
+
+  uint8_t detect(void);
+
+  uint16_t writeAsync(uint16_t addr, const uint8_t *buf, uint16_t len);
+
+  uint16_t readAsync(uint16_t addr, uint8_t *buf, uint16_t len);
+
+  bool asyncDone();
+
 private:
 
+  bool _asyncBusy = false;
+  uint8_t _bufShift = 11;      // log2(SSIZE)
+  uint8_t _txControl[8];       // control byte of the TX buffer of each socket
+  uint8_t _rxControl[8];       // control byte of the RX buffer of each socket
+
+  void header(uint16_t addr, uint8_t *cmd, uint8_t rw);
+
   uint16_t write(uint16_t addr, const uint8_t *buf, uint16_t len);
 
   uint16_t read(uint16_t addr, uint8_t *buf, uint16_t len);
@@ -12,6 +12,7 @@
 #include <Arduino.h>
 #include "EthernetAdv.h"
 #include "W5x00.h"
+#include "W5x00Bus.h"
 
 // Generic
 // Soft reset the WIZnet chip, by writing to its MR register reset bit
@@ -34,6 +35,59 @@ uint8_t W5x00Class::softReset(void)
 }
 
 // Generic
+// Wait until the chip can be used, returns 0 if it did not respond in time
+uint8_t W5x00Class::waitReady(void)
+{
+	uint32_t start = micros();
+	uint8_t ret = 1;
+
+	switch (_resetMode) {
+		case RESET_DELAY:
+			delay(_resetDelay);
+			break;
+		case RESET_PIN:
+			// W5500 needs a 500 us pulse, W5100 and W5200 only 2 us
+			pinMode(_resetPin, OUTPUT);
+			digitalWrite(_resetPin, LOW);
+			delayMicroseconds(500);
+			digitalWrite(_resetPin, HIGH);
+			// fall through
+		case RESET_POLL:
+			while (!detect()) {
+				if (micros() - start >= (uint32_t)_resetDelay * 1000) {
+					ret = 0;
+					break;
+				}
+				delay(1);
+			}
+			break;
+		case RESET_NONE:
+			break;
+	}
+	_readyTime = micros() - start;
+	return ret;
+}
+
+// Generic
+void W5x00Class::traceEnd(uint32_t start, uint16_t addr, const uint8_t *buf, uint16_t len, uint8_t flags)
+{
+	if (!_tracer) return;
+	W5x00TraceRecord rec;
+	rec.time = start;
+	rec.duration = (flags & W5X00_TRACE_ASYNC) ? 0 : micros() - start;
+	rec.addr = addr;
+	rec.len = len;
+	if (len == 1) {
+		rec.value = buf[0];
+	} else if (len == 2 && !(flags & W5X00_TRACE_ASYNC)) {
+		rec.value = (buf[0] << 8) | buf[1];
+	} else {
+		rec.value = 0;
+	}
+	rec.flags = flags | (chip() << 4);
+	_tracer->record(rec);
+}
+
 void W5x00Class::execCmdSn(SOCKET s, SockCMD _cmd)
 {
 	// Send command to socket
@@ -42,7 +96,88 @@ void W5x00Class::execCmdSn(SOCKET s, SockCMD _cmd)
 	while (readSnCR(s)) ;
 }
 
+// Generic
+// The clocks calibrateSPI() tries, the SPI peripheral rounds them down
+// to what it can make.
+static const uint32_t spiClocks[] = {
+	4000000, 8000000, 10000000, 12000000, 14000000, 16000000, 20000000,
+	25000000, 30000000, 33000000, 40000000, 50000000, 60000000, 80000000
+};
+
+// Write and read back test patterns in the destination IP register of
+// socket 0, which is not used before a socket is opened.
+uint32_t W5x00Class::calibrateSPI(uint32_t minClock, uint32_t maxClock)
+{
+	static const uint8_t patterns[][4] = {
+		{0x00, 0x00, 0x00, 0x00}, {0xFF, 0xFF, 0xFF, 0xFF},
+		{0xAA, 0x55, 0xAA, 0x55}, {0x55, 0xAA, 0x55, 0xAA},
+		{0x01, 0x80, 0x7F, 0xFE}, {0x0F, 0xF0, 0x3C, 0xC3}
+	};
+	uint32_t best = 0;
+	uint8_t saved[4];
+	uint8_t buf[4];
+
+	if (!init()) return 0;
+
+	setSPIClock(minClock);
+	beginTransaction();
+	readSnDIPR(0, saved);
+	endTransaction();
+
+	for (uint8_t c = 0; c <= sizeof(spiClocks) / sizeof(spiClocks[0]); c++) {
+		// minClock itself is tried first
+		uint32_t clock = c ? spiClocks[c - 1] : minClock;
+		if (c && clock <= minClock) continue;
+		if (clock > maxClock) break;
+
+		bool ok = true;
+		setSPIClock(clock);
+		beginTransaction();
+		for (uint8_t i = 0; ok && i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+			memcpy(buf, patterns[i], 4);
+			writeSnDIPR(0, buf);
+			readSnDIPR(0, buf);
+			if (memcmp(buf, patterns[i], 4) != 0) ok = false;
+		}
+		endTransaction();
+		if (!ok) break;
+		best = clock;
+	}
+
+	// Keep the last clock that worked, the first failure may have left
+	// garbage in the register so restore it at that clock.
+	setSPIClock(best ? best : minClock);
+	beginTransaction();
+	writeSnDIPR(0, saved);
+	endTransaction();
+	return best;
+}
+
+// Generic
+void W5x00Class::setSPISettings(const SPISettings &settings, uint32_t clock)
+{
+	// A transaction kept open by the bus still uses the old settings
+	if (_bus) _bus->flush();
+	_spiSettings = settings;
+	_spiClock = clock;
+}
+
+// Generic
+// Nested transactions share the SPI transaction of the outer one
+void W5x00Class::beginTransaction(){
+	// Other tasks wait here, _txDepth belongs to the task holding the lock
+	if (_lock) _lock->lock();
+	if (_txDepth++) return;
+	if (_bus) _bus->acquire(_busDevice);
+	else spi->beginTransaction(_spiSettings);
+}
+
 // Generic
 void W5x00Class::endTransaction(){
-	spi->endTransaction();
+	if (_txDepth == 0) return;
+	if (--_txDepth == 0) {
+		if (_bus) _bus->release(_busDevice);
+		else spi->endTransaction();
+	}
+	if (_lock) _lock->unlock();
 }
@@ -20,6 +20,8 @@
 
 typedef uint8_t SOCKET;
 
+class W5x00Bus;
+
 class SnMR {
 public:
   static const uint8_t CLOSE  = 0x00;
@@ -29,7 +31,10 @@ public:
   static const uint8_t MACRAW = 0x04;
   static const uint8_t PPPOE  = 0x05;
   static const uint8_t ND     = 0x20;
+  static const uint8_t MC     = 0x20;  // With MULTI: use IGMP version 1 instead of 2
   static const uint8_t MULTI  = 0x80;
+  static const uint8_t MFEN   = 0x80;  // With MACRAW: only receive frames for our MAC (W5500)
+  static const uint8_t MF     = 0x40;  // With MACRAW: only receive frames for our MAC (W5200)
 };
 
 enum SockCMD {
@@ -92,6 +97,82 @@ enum W5x00Linkstatus {
   LINK_OFF
 };
 
+// How init() waits for the chip after power up
+enum W5x00ResetMode {
+  RESET_DELAY,  // wait the reset delay (default)
+  RESET_POLL,   // poll the chip until it responds, at most the reset delay
+  RESET_PIN,    // pulse the reset pin, then poll like RESET_POLL
+  RESET_NONE    // don't wait
+};
+
+enum W5x00Chip {
+  CHIP_NONE,
+  CHIP_W5100,
+  CHIP_W5200,
+  CHIP_W5500
+};
+
+// Set to 1 to count traffic per socket, see EthernetClass::socketStats().
+// Costs about 60 bytes of RAM per socket and a few instructions per access.
+// Changes the class layout, so set it as a global build flag.
+#ifndef ETHERNET_SOCKET_STATS
+#define ETHERNET_SOCKET_STATS 0
+#endif
+
+// Transfers shorter than this are not worth setting up a background transfer
+#define W5X00_ASYNC_MIN_SIZE 64
+
+// Backend that clocks buffer data over SPI in the background, e.g. with DMA.
+// Either tx or rx can be NULL.  start() returns false if the transfer can't
+// be done in the background, the driver then does it itself.
+class W5x00AsyncTransfer {
+public:
+  virtual bool start(SPIClass *spi, const uint8_t *tx, uint8_t *rx, uint16_t len) = 0;
+  virtual bool done() = 0;
+};
+
+#if defined(ARDUINO_ARCH_RP2040)
+// Uses the DMA transfers of the Raspberry Pi Pico core
+class W5x00RP2040Transfer : public W5x00AsyncTransfer {
+public:
+  bool start(SPIClass *spi, const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    _spi = spi;
+    return _spi->transferAsync(tx, rx, len);
+  }
+  bool done() { return _spi->finishedAsync(); }
+private:
+  SPIClass *_spi;
+};
+#endif
+
+// One SPI access, as recorded for a W5x00Tracer
+typedef struct {
+  uint32_t time;     // micros() at the start of the access
+  uint16_t duration; // us, 0 for background transfers
+  uint16_t addr;     // address as used by the library, see SBASE() and RBASE()
+  uint16_t len;
+  uint16_t value;    // data of 1 and 2 byte accesses, 0 otherwise
+  uint8_t  flags;    // W5X00_TRACE_WRITE, W5X00_TRACE_ASYNC, chip << 4
+} W5x00TraceRecord;
+
+#define W5X00_TRACE_WRITE 0x01
+#define W5X00_TRACE_ASYNC 0x02
+
+// Receives every read and write of a chip, e.g. the ring buffer W5x00Trace.
+// Called right after the access, so it should be quick.
+class W5x00Tracer {
+public:
+  virtual void record(const W5x00TraceRecord &rec) = 0;
+};
+
+// Recursive lock held during the transactions of a chip, so several tasks
+// can use it.  See EthernetClass::setLocking().
+class W5x00Lock {
+public:
+  virtual void lock() = 0;
+  virtual void unlock() = 0;
+};
+
 class W5x00Class {
 
   // Interface functions that need to be impelmented
@@ -105,7 +186,7 @@ public:
 
   virtual W5x00Linkstatus getLinkStatus() = 0;
 
-  virtual void beginTransaction() = 0;
+  virtual void beginTransaction();
 
   virtual uint16_t SBASE(uint8_t socknum) = 0;
 
@@ -117,6 +198,15 @@ public:
 
   virtual uint16_t read(uint16_t addr, uint8_t *buf, uint16_t len) = 0;
 
+  virtual W5x00Chip chip() = 0;
+
+  // Sn_MR bit that limits a MACRAW socket to frames for our MAC address,
+  // broadcast and multicast, or 0 if the chip can't filter them
+  virtual uint8_t macFilterMode() { return 0; }
+
+  // Check if this chip is responding, without the reset delay of init()
+  virtual uint8_t detect(void) = 0;
+
   // Generic for W5x00 Classes (already implemented)
   // -------------------------
 public:
@@ -140,9 +230,39 @@ public:
   inline IPAddress getRemoteIp(SOCKET s) { uint8_t i[4]; readSnDIPR(s, i); return IPAddress(i); }
   inline uint16_t getRemotePort(SOCKET s) { return readSnDPORT(s); }
 
-  void endTransaction();
+  virtual void endTransaction();
+
+  // Background transfers of buffer data, see W5x00AsyncTransfer.  Chips
+  // that don't support them complete the transfer before returning.
+  virtual void setAsyncTransfer(W5x00AsyncTransfer *backend) { _async = backend; }
+  virtual uint16_t writeAsync(uint16_t addr, const uint8_t *buf, uint16_t len) { return write(addr, buf, len); }
+  virtual uint16_t readAsync(uint16_t addr, uint8_t *buf, uint16_t len) { return read(addr, buf, len); }
+  // Returns true when the last background transfer has finished
+  virtual bool asyncDone() { return true; }
+
+  // Take lock during every transaction, NULL for no locking
+  virtual void setLock(W5x00Lock *lock) { _lock = lock; }
+
+  // Report every read and write to tracer, NULL stops tracing
+  virtual void setTracer(W5x00Tracer *tracer) { _tracer = tracer; }
+
+  // Share the SPI bus through a bus arbiter, see W5x00Bus::add()
+  virtual void setBus(W5x00Bus *bus, uint8_t device) { _bus = bus; _busDevice = device; }
+
+  // SPI settings of this chip, the default clock depends on the chip type
+  virtual void setSPISettings(const SPISettings &settings, uint32_t clock);
+  void setSPIClock(uint32_t clock) { setSPISettings(SPISettings(clock, MSBFIRST, SPI_MODE0), clock); }
+  const SPISettings& spiSettings() { return _spiSettings; }
+  uint32_t spiClock() { return _spiClock; }
+
+  // Find the highest SPI clock between minClock and maxClock at which the
+  // registers can be written and read back reliably, and use it.
+  // Returns the selected clock, or 0 if the chip did not respond at minClock.
+  virtual uint32_t calibrateSPI(uint32_t minClock, uint32_t maxClock);
 
   uint8_t maxSockNum() { return _maxSockNum; }
+  // Use at most n sockets.  Before init() this also gives them larger buffers.
+  virtual void limitSockNum(uint8_t n) { if (n < _maxSockNum) _maxSockNum = n; }
 
   void setSS(uint8_t pin) { ss_pin = pin; }
 
@@ -150,6 +270,14 @@ public:
 
   bool initialized() { return _initialized; }
 
+  // Time init() waits for the reset chip on the board to release the W5x00
+  void setResetDelay(uint16_t milliseconds) { _resetDelay = milliseconds; }
+  void setResetMode(W5x00ResetMode mode) { _resetMode = mode; }
+  // Reset the chip with this pin (active low) instead of waiting for a reset chip
+  void setResetPin(uint8_t pin) { _resetPin = pin; _resetMode = RESET_PIN; }
+  // Microseconds init() waited before the chip was ready
+  uint32_t readyTime() { return _readyTime; }
+
   uint8_t write(uint16_t addr, uint8_t data) {
     return write(addr, &data, 1);
   }
@@ -165,12 +293,28 @@ public:
 
 protected:
   SPIClass* spi;
+  W5x00Bus* _bus = NULL;
+  uint8_t _busDevice;
+  SPISettings _spiSettings;
+  uint32_t _spiClock;
   uint8_t ss_pin;
   uint8_t _maxSockNum;
   uint8_t CH_BASE_MSB; // 1 redundant byte, saves ~80 bytes code on AVR
   bool _initialized = false;
+  uint16_t _resetDelay = 560;
+  W5x00ResetMode _resetMode = RESET_DELAY;
+  uint8_t _resetPin;
+  uint32_t _readyTime = 0;
+  uint8_t _txDepth = 0; // nesting level of beginTransaction()
+  W5x00AsyncTransfer* _async = NULL;
+  W5x00Tracer* _tracer = NULL;
+  W5x00Lock* _lock = NULL;
 
   uint8_t softReset(void);
+  uint8_t waitReady(void);
+  // Used by read() and write() of the drivers to report to the tracer
+  inline uint32_t traceStart() { return _tracer ? micros() : 0; }
+  void traceEnd(uint32_t start, uint16_t addr, const uint8_t *buf, uint16_t len, uint8_t flags);
   
 #define __GP_REGISTER8(name, address)             \
   inline void write##name(uint8_t _data) {        \
@@ -238,16 +382,29 @@ public:
   
   const uint16_t CH_SIZE = 0x0100;
 
+#if ETHERNET_SOCKET_STATS
+  // SPI reads and writes, and their data bytes, for each socket
+  uint32_t sockSpiOps[8] = {};
+  uint32_t sockSpiBytes[8] = {};
+  inline void sockSpiStat(SOCKET s, uint16_t len) { sockSpiOps[s]++; sockSpiBytes[s] += len; }
+#else
+  inline void sockSpiStat(SOCKET, uint16_t) {}
+#endif
+
   inline uint8_t readSn(SOCKET s, uint16_t addr) {
+    sockSpiStat(s, 1);
     return read(CH_BASE() + s * CH_SIZE + addr);
   }
   inline uint8_t writeSn(SOCKET s, uint16_t addr, uint8_t data) {
+    sockSpiStat(s, 1);
     return write(CH_BASE() + s * CH_SIZE + addr, data);
   }
   inline uint16_t readSn(SOCKET s, uint16_t addr, uint8_t *buf, uint16_t len) {
+    sockSpiStat(s, len);
     return read(CH_BASE() + s * CH_SIZE + addr, buf, len);
   }
   inline uint16_t writeSn(SOCKET s, uint16_t addr, uint8_t *buf, uint16_t len) {
+    sockSpiStat(s, len);
     return write(CH_BASE() + s * CH_SIZE + addr, buf, len);
   }
 
@@ -298,6 +455,7 @@ public:
   __SOCKET_REGISTER16(SnRX_RSR,   0x0026)        // RX Free Size
   __SOCKET_REGISTER16(SnRX_RD,    0x0028)        // RX Read Pointer
   __SOCKET_REGISTER16(SnRX_WR,    0x002A)        // RX Write Pointer (supported?)
+  __SOCKET_REGISTER8(SnKPALVTR,   0x002F)        // Keep Alive Timer, 5 s units (W5500 only)
 
 #undef __SOCKET_REGISTER8
 #undef __SOCKET_REGISTER16
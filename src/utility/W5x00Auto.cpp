@@ -0,0 +1,154 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+#include "W5x00Auto.h"
+
+W5x00Auto::W5x00Auto(SPIClass &spi, uint8_t sspin, uint8_t maxSockNum)
+	: _w5100(spi, sspin, maxSockNum), _w5200(spi, sspin, maxSockNum), _w5500(spi, sspin, maxSockNum){
+	this->spi = &spi;
+	ss_pin = sspin;
+	_maxSockNum = _w5500.maxSockNum(); // Largest of all chips, the socket states are allocated with this
+	_spiClock = 0; // Use the default of the chip that is found
+	_chip = NULL;
+	_hint = CHIP_NONE;
+}
+
+W5x00Auto::W5x00Auto(SPIClass &spi, uint8_t sspin)
+	: _w5100(spi, sspin), _w5200(spi, sspin), _w5500(spi, sspin){
+	this->spi = &spi;
+	ss_pin = sspin;
+	_maxSockNum = _w5500.maxSockNum();
+	_spiClock = 0;
+	_chip = NULL;
+	_hint = CHIP_NONE;
+}
+
+W5x00Class* W5x00Auto::driver(W5x00Chip chip)
+{
+	switch (chip) {
+		case CHIP_W5100: return &_w5100;
+		case CHIP_W5200: return &_w5200;
+		case CHIP_W5500: return &_w5500;
+		default: return NULL;
+	}
+}
+
+uint8_t W5x00Auto::detect(void)
+{
+	// Try the chip we were told about first
+	W5x00Class* hinted = driver(_hint);
+	if (hinted && hinted->detect()) {
+		_chip = hinted;
+		return 1;
+	}
+
+	// Attempt W5200 detection first, because W5200 does not properly
+	// reset its SPI state when CS goes high (inactive).  Communication
+	// from detecting the other chips can leave the W5200 in a state
+	// where it won't recover, unless given a reset pulse.
+	if (_w5200.detect()) {
+		_chip = &_w5200;
+	} else if (_w5500.detect()) {
+		_chip = &_w5500;
+	} else if (_w5100.detect()) {
+		_chip = &_w5100;
+	} else {
+		_chip = NULL;
+		return 0;
+	}
+	return 1;
+}
+
+// A clock set for this instance is used by the drivers, for probing as well
+void W5x00Auto::setSPISettings(const SPISettings &settings, uint32_t clock)
+{
+	W5x00Class::setSPISettings(settings, clock);
+	_w5100.setSPISettings(settings, clock);
+	_w5200.setSPISettings(settings, clock);
+	_w5500.setSPISettings(settings, clock);
+}
+
+// The driver does the transfers, its result is used by all drivers
+uint32_t W5x00Auto::calibrateSPI(uint32_t minClock, uint32_t maxClock)
+{
+	if (!_chip && !detect()) return 0;
+	uint32_t clock = _chip->calibrateSPI(minClock, maxClock);
+	setSPISettings(_chip->spiSettings(), _chip->spiClock());
+	return clock;
+}
+
+void W5x00Auto::setAsyncTransfer(W5x00AsyncTransfer *backend)
+{
+	W5x00Class::setAsyncTransfer(backend);
+	_w5100.setAsyncTransfer(backend);
+	_w5200.setAsyncTransfer(backend);
+	_w5500.setAsyncTransfer(backend);
+}
+
+// The drivers access the bus themselves during init()
+void W5x00Auto::setBus(W5x00Bus *bus, uint8_t device)
+{
+	W5x00Class::setBus(bus, device);
+	_w5100.setBus(bus, device);
+	_w5200.setBus(bus, device);
+	_w5500.setBus(bus, device);
+}
+
+// The drivers do the reads and writes, so they report them
+void W5x00Auto::setTracer(W5x00Tracer *tracer)
+{
+	W5x00Class::setTracer(tracer);
+	_w5100.setTracer(tracer);
+	_w5200.setTracer(tracer);
+	_w5500.setTracer(tracer);
+}
+
+// The drivers do the transactions once the chip is found
+void W5x00Auto::setLock(W5x00Lock *lock)
+{
+	W5x00Class::setLock(lock);
+	_w5100.setLock(lock);
+	_w5200.setLock(lock);
+	_w5500.setLock(lock);
+}
+
+void W5x00Auto::limitSockNum(uint8_t n)
+{
+	W5x00Class::limitSockNum(n);
+	_w5100.limitSockNum(n);
+	_w5200.limitSockNum(n);
+	_w5500.limitSockNum(n);
+}
+
+uint8_t W5x00Auto::init(void)
+{
+	if (_initialized) return 1;
+
+	// Wait for the reset chip only once instead of once per probed chip,
+	// when polling waitReady() already detects the chip.
+	_chip = NULL;
+	if (!waitReady()) return 0;
+	if (!_chip && !detect()) return 0;
+
+	// Without a clock of our own use the default of the chip
+	if (!_spiClock) W5x00Class::setSPISettings(_chip->spiSettings(), _chip->spiClock());
+	_chip->setResetMode(RESET_NONE);
+	if (!_chip->init()) return 0;
+
+	// The generic register functions of this class use these
+	CH_BASE_MSB = _chip->CH_BASE() >> 8;
+	SSIZE = _chip->SSIZE;
+	SMASK = _chip->SMASK;
+	_maxSockNum = _chip->maxSockNum();
+	_hint = _chip->chip();
+	_initialized = true;
+	return 1;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// W5x00Auto finds out at runtime which WIZnet chip is connected and
+// passes all calls on to the matching W5100, W5200 or W5500 driver.
+
+#ifndef	W5X00AUTO_H_INCLUDED
+#define	W5X00AUTO_H_INCLUDED
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "W5x00.h"
+#include "W5100.h"
+#include "W5200.h"
+#include "W5500.h"
+
+class W5x00Auto: public W5x00Class {
+
+public:
+  W5x00Auto(SPIClass &spi, uint8_t sspin, uint8_t maxSockNum);
+
+  W5x00Auto(SPIClass &spi, uint8_t sspin);
+
+  uint8_t init(void);
+
+  W5x00Linkstatus getLinkStatus() { return _chip ? _chip->getLinkStatus() : UNKNOWN; }
+
+  // Until init() has found the chip there is nothing to access, so these
+  // return 0 and reads and writes transfer nothing.
+  uint16_t SBASE(uint8_t socknum) { return _chip ? _chip->SBASE(socknum) : 0; }
+
+  uint16_t RBASE(uint8_t socknum) { return _chip ? _chip->RBASE(socknum) : 0; }
+
+  const bool hasOffsetAddressMapping() { return _chip ? _chip->hasOffsetAddressMapping() : false; }
+
+  uint8_t macFilterMode() { return _chip ? _chip->macFilterMode() : 0; }
+
+  // Once the chip is known its driver keeps track of the transactions, so
+  // they nest with the ones the driver starts itself.
+  void beginTransaction() { if (_chip) _chip->beginTransaction(); else W5x00Class::beginTransaction(); }
+  void endTransaction() { if (_chip) _chip->endTransaction(); else W5x00Class::endTransaction(); }
+
+  void setSPISettings(const SPISettings &settings, uint32_t clock);
+
+  // Calibrates with the driver of the chip, detecting it first if needed
+  uint32_t calibrateSPI(uint32_t minClock, uint32_t maxClock);
+
+  uint16_t writeAsync(uint16_t addr, const uint8_t *buf, uint16_t len) { return _chip ? _chip->writeAsync(addr, buf, len) : 0; }
+
+  uint16_t readAsync(uint16_t addr, uint8_t *buf, uint16_t len) { return _chip ? _chip->readAsync(addr, buf, len) : 0; }
+
+  bool asyncDone() { return _chip ? _chip->asyncDone() : true; }
+
+  void setAsyncTransfer(W5x00AsyncTransfer *backend);
+
+  // The chip that was found, CHIP_NONE before init()
+  W5x00Chip chip() { return _chip ? _chip->chip() : CHIP_NONE; }
+
+  uint8_t detect(void);
+
+  void setBus(W5x00Bus *bus, uint8_t device);
+  void setTracer(W5x00Tracer *tracer);
+  void setLock(W5x00Lock *lock);
+  void limitSockNum(uint8_t n);
+
+  // Skip probing when the chip is already known, e.g. stored from an earlier
+  // run.  If the chip does not respond, all chips are probed again.
+  void setChip(W5x00Chip chip) { _hint = chip; }
+
+private:
+  W5100Class _w5100;
+  W5200Class _w5200;
+  W5500Class _w5500;
+  W5x00Class* _chip;
+  W5x00Chip _hint;
+
+  W5x00Class* driver(W5x00Chip chip);
+
+  uint16_t write(uint16_t addr, const uint8_t *buf, uint16_t len) {
+    if (!_chip) return 0;
+    return _chip->write(addr, buf, len);
+  }
+
+  uint16_t read(uint16_t addr, uint8_t *buf, uint16_t len) {
+    if (!_chip) {
+      memset(buf, 0, len);
+      return 0;
+    }
+    return _chip->read(addr, buf, len);
+  }
+
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include <Arduino.h>
+#include "EthernetAdv.h"
+#include "W5x00Bus.h"
+
+W5x00Bus::W5x00Bus(SPIClass &spi){
+	_spi = &spi;
+	_numDevices = 0;
+	_coalesce = false;
+	_maxHold = W5X00_BUS_MAX_HOLD;
+	_open = false;
+	_held = false;
+	_flush = false;
+	resetStats();
+}
+
+uint8_t W5x00Bus::add(W5x00Class &chip)
+{
+	if (_numDevices >= W5X00_BUS_MAX_DEVICES) return W5X00_BUS_MAX_DEVICES;
+	_devices[_numDevices].settings = &chip.spiSettings();
+	chip.setBus(this, _numDevices);
+	return _numDevices++;
+}
+
+uint8_t W5x00Bus::addPeripheral()
+{
+	if (_numDevices >= W5X00_BUS_MAX_DEVICES) return W5X00_BUS_MAX_DEVICES;
+	_devices[_numDevices].settings = NULL;
+	return _numDevices++;
+}
+
+void W5x00Bus::acquire(uint8_t device)
+{
+	device_t &d = _devices[device];
+
+	if (_lock) _lock->lock();
+	// Another device is between acquire() and release(), e.g. in an
+	// EthernetTransaction or a background transfer with its chip selected.
+	// Its SPI transaction must not be ended under it.
+	while (_held && _owner != device) {
+		yield();
+	}
+	uint32_t now = micros();
+
+	d.stats.transactions++;
+	d.since = now;
+	if (_open && _owner == device && !_flush && now - _openedAt < _maxHold) {
+		d.stats.coalesced++;
+		_held = true;
+		return;
+	}
+	close();
+	_held = true;
+	_owner = device;
+	// Peripherals do their own SPI transactions
+	if (d.settings) {
+		_spi->beginTransaction(*d.settings);
+		_open = true;
+		_openedAt = now;
+	}
+}
+
+void W5x00Bus::release(uint8_t device)
+{
+	device_t &d = _devices[device];
+	uint32_t now = micros();
+
+	d.stats.busyMicros += now - d.since;
+	// A device waiting in acquire() goes on once _held is cleared
+	if (!_coalesce || _flush || now - _openedAt >= _maxHold) close();
+	_held = false;
+	if (_lock) _lock->unlock();
+}
+
+void W5x00Bus::flush()
+{
+	// A transaction in use is ended by its release()
+	if (_held) {
+		_flush = true;
+	} else {
+		close();
+	}
+}
+
+void W5x00Bus::poll()
+{
+	if (_open && !_held && micros() - _openedAt >= _maxHold) close();
+}
+
+void W5x00Bus::close()
+{
+	if (_open) {
+		_spi->endTransaction();
+		_open = false;
+	}
+	_held = false;
+	_flush = false;
+}
+
+const W5x00BusStats* W5x00Bus::stats(uint8_t device)
+{
+	if (device >= _numDevices) return NULL;
+	return &_devices[device].stats;
+}
+
+uint8_t W5x00Bus::occupancy(uint8_t device)
+{
+	if (device >= _numDevices) return 0;
+	uint32_t elapsed = micros() - _statsSince;
+	if (elapsed == 0) return 0;
+	return (uint64_t)_devices[device].stats.busyMicros * 100 / elapsed;
+}
+
+void W5x00Bus::resetStats()
+{
+	for (uint8_t i = 0; i < W5X00_BUS_MAX_DEVICES; i++) {
+		_devices[i].stats.transactions = 0;
+		_devices[i].stats.coalesced = 0;
+		_devices[i].stats.busyMicros = 0;
+	}
+	_statsSince = micros();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// W5x00Bus arbitrates one SPI bus between several W5x00 chips and other
+// SPI peripherals.  Back-to-back transactions of the same chip can be merged
+// into one SPI transaction, and the bus time of every device is recorded.
+
+#ifndef	W5X00BUS_H_INCLUDED
+#define	W5X00BUS_H_INCLUDED
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#define W5X00_BUS_MAX_DEVICES 4
+#define W5X00_BUS_MAX_HOLD 2000  // us
+
+class W5x00Class;
+class W5x00Lock;
+
+typedef struct {
+  uint32_t transactions; // number of times the device got the bus
+  uint32_t coalesced;    // ... of which without a new SPI transaction
+  uint32_t busyMicros;   // time the device used the bus
+} W5x00BusStats;
+
+class W5x00Bus {
+
+public:
+  W5x00Bus(SPIClass &spi);
+
+  // Register a chip, all its transactions go through the bus from now on.
+  // Returns the device number, or W5X00_BUS_MAX_DEVICES if the bus is full.
+  uint8_t add(W5x00Class &chip);
+  // Register another SPI user, e.g. an SD card.  It must call acquire()
+  // before and release() after using the bus.
+  uint8_t addPeripheral();
+
+  // acquire() waits while another device holds the bus, i.e. until that
+  // device calls release().  On a single task, release one device before
+  // acquiring another, acquire() would wait forever otherwise.
+  void acquire(uint8_t device);
+  void release(uint8_t device);
+  // End a transaction that is kept open for merging, e.g. before code that
+  // does not use the bus arbiter accesses the SPI bus.  A transaction that
+  // is in use is ended when its device releases the bus.
+  void flush();
+  // End a transaction kept open for merging once it has been open for the
+  // maximum hold time.  Call it regularly while merging is enabled.
+  void poll();
+
+  // Keep the SPI transaction open after release() so the next transaction
+  // of the same chip doesn't need a new one.  Disabled by default: the SPI
+  // bus lock stays taken until another device acquires the bus, the hold
+  // time has passed at a release() or poll(), or flush() is called.
+  void setCoalesce(bool coalesce) { _coalesce = coalesce; if (!coalesce) flush(); }
+  // Longest time a transaction is kept open for one chip, so the SPI bus
+  // lock is given up regularly even when one interface is very busy.
+  void setMaxHold(uint32_t microseconds) { _maxHold = microseconds; }
+  // Held from acquire() to release(), so tasks that use different devices
+  // wait for each other on it instead of spinning in acquire().  Must be
+  // recursive, e.g. an EthernetMutexLock.  NULL for no lock.
+  void setLock(W5x00Lock *lock) { _lock = lock; }
+
+  const W5x00BusStats* stats(uint8_t device);
+  // Percentage of time device used the bus since the last resetStats()
+  uint8_t occupancy(uint8_t device);
+  void resetStats();
+
+private:
+  typedef struct {
+    const SPISettings* settings; // NULL for peripherals
+    uint32_t since;
+    W5x00BusStats stats;
+  } device_t;
+
+  SPIClass* _spi;
+  device_t _devices[W5X00_BUS_MAX_DEVICES];
+  uint8_t _numDevices;
+  bool _coalesce;
+  uint32_t _maxHold;
+  bool _open;          // an SPI transaction is open
+  volatile bool _held; // a device acquired the bus and has not released it yet
+  volatile uint8_t _owner; // device that acquired it
+  bool _flush;         // flush() was called while the bus was held
+  W5x00Lock* _lock = NULL;
+  uint32_t _openedAt;
+  uint32_t _statsSince;
+
+  void close();
+};
+
+#endif
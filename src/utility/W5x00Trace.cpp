@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include <Arduino.h>
+#include "W5x00Trace.h"
+
+W5x00Trace::W5x00Trace(W5x00TraceRecord *records, uint16_t size){
+	_records = records;
+	_size = size;
+	_chip = NULL;
+	_paused = false;
+	clear();
+}
+
+void W5x00Trace::begin(W5x00Class &chip)
+{
+	stop();
+	_chip = &chip;
+	_chip->setTracer(this);
+}
+
+void W5x00Trace::stop()
+{
+	if (_chip) _chip->setTracer(NULL);
+}
+
+void W5x00Trace::clear()
+{
+	_head = 0;
+	_count = 0;
+	_total = 0;
+}
+
+void W5x00Trace::record(const W5x00TraceRecord &rec)
+{
+	if (_paused || _size == 0) return;
+	_records[_head] = rec;
+	if (++_head == _size) _head = 0;
+	if (_count < _size) _count++;
+	_total++;
+}
+
+const W5x00TraceRecord& W5x00Trace::get(uint16_t i)
+{
+	uint16_t first = (_head + _size - _count) % _size;
+	return _records[(first + i) % _size];
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	put16(p, v & 0xFFFF);
+	put16(p + 2, v >> 16);
+}
+
+size_t W5x00Trace::dump(Print &out)
+{
+	uint8_t buf[16];
+	size_t n = 0;
+
+	_paused = true;
+	memcpy(buf, "W5TR", 4);
+	buf[4] = W5X00_TRACE_VERSION;
+	buf[5] = _chip ? _chip->chip() : CHIP_NONE;
+	buf[6] = _chip ? _chip->maxSockNum() : 0;
+	buf[7] = 0;
+	put16(buf + 8, _chip ? _chip->SSIZE : 0);
+	put16(buf + 10, _count);
+	put32(buf + 12, dropped());
+	n += out.write(buf, 16);
+
+	for (uint16_t i = 0; i < _count; i++) {
+		const W5x00TraceRecord &rec = get(i);
+		put32(buf, rec.time);
+		put16(buf + 4, rec.duration);
+		put16(buf + 6, rec.addr);
+		put16(buf + 8, rec.len);
+		put16(buf + 10, rec.value);
+		buf[12] = rec.flags;
+		n += out.write(buf, 13);
+	}
+	_paused = false;
+	return n;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 Lode Van Dyck
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// W5x00Trace keeps the last SPI accesses of a chip in a ring buffer and
+// writes them out in a compact binary format, which extras/w5x00trace.py
+// turns into per-socket timelines.
+//
+// Dump format, all numbers little endian:
+//   header  "W5TR", version (1), chip (1), sockets (1), 0 (1),
+//           socket buffer size (2), records (2), dropped records (4)
+//   record  time (4), duration (2), addr (2), len (2), value (2), flags (1)
+// The fields of a record are those of W5x00TraceRecord, oldest first.
+
+#ifndef	W5X00TRACE_H_INCLUDED
+#define	W5X00TRACE_H_INCLUDED
+
+#include <Arduino.h>
+#include "W5x00.h"
+
+#define W5X00_TRACE_VERSION 1
+
+class W5x00Trace: public W5x00Tracer {
+
+public:
+  // records is a buffer for size accesses, e.g. 256 records use 4 kB
+  W5x00Trace(W5x00TraceRecord *records, uint16_t size);
+
+  // Record the accesses of chip until stop()
+  void begin(W5x00Class &chip);
+  void stop();
+  void clear();
+
+  void record(const W5x00TraceRecord &rec);
+
+  // Records in the buffer, and records that were overwritten
+  uint16_t count() { return _count; }
+  uint32_t dropped() { return _total - _count; }
+  // The i-th oldest record
+  const W5x00TraceRecord& get(uint16_t i);
+
+  // Write the buffer in the dump format, returns the number of bytes written.
+  // Recording is paused meanwhile.
+  size_t dump(Print &out);
+
+private:
+  W5x00TraceRecord* _records;
+  uint16_t _size;
+  uint16_t _head;   // next record to write
+  uint16_t _count;
+  uint32_t _total;  // records since clear()
+  W5x00Class* _chip;
+  bool _paused;
+};
+
+#endif